@@ -0,0 +1,249 @@
+// End-to-end throughput and latency of the Web API client against the in-process mock of slack.com (mock_server.hpp).
+// Every client thread owns a Slacking instance and keeps its connection alive, as a service would.
+//
+//     load_bench [--threads N] [--requests N] [--payload BYTES] [--users N] [--page N] [--latency MICROSECONDS] [--teams N]
+//
+// Reports requests per second, p50/p99/p99.9 latency, heap allocations and CPU time per request made by the client,
+// and the bytes per request on the sockets of the mock (0 in memory): compressed scenarios trade the latter for CPU.
+
+#include "slacking.hpp"
+#include "mock_server.hpp"
+#include "client_pool.hpp"
+#include "compression.hpp"
+#include "methods.hpp"
+#include "webhook.hpp"
+
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <new>
+
+#include <time.h>
+
+namespace {
+
+// Allocations made by the threads which opted in: the client threads, not the mock server
+std::atomic<std::uint64_t> allocations{0};
+thread_local bool          count_allocations = false;
+
+const slack::MockSlack*    wire = nullptr; // counts the bytes of the scenarios
+
+} // namespace
+
+// not inlined, or GCC sees the malloc behind new and the free behind delete and warns of a mismatch
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    if (count_allocations) { allocations.fetch_add(1, std::memory_order_relaxed); }
+    if (void* p = std::malloc(size ? size : 1)) { return p; }
+    throw std::bad_alloc{};
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Options {
+    unsigned    threads{8};
+    std::size_t requests{20000};  // per scenario, spread over the threads
+    std::size_t payload{256};     // bytes of message text
+    std::size_t users{2000};      // users returned by users.list
+    std::size_t page{200};        // users per page
+    std::size_t latency{0};       // microseconds added by the mock to every answer
+    std::size_t teams{200};       // workspaces of the client pool
+};
+
+struct Result {
+    double        seconds;
+    std::size_t   requests;
+    std::vector<std::chrono::nanoseconds> latencies;
+    std::uint64_t allocations;
+    std::chrono::nanoseconds cpu;  // of the client threads
+    std::uint64_t wire_bytes;
+};
+
+std::chrono::nanoseconds thread_cpu() {
+    timespec now;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+}
+
+// Run calls split over the threads, each thread with its own client prepared by setup
+template<typename Setup, typename Call>
+Result run(const Options& options, std::size_t calls, Setup setup, Call call) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<std::chrono::nanoseconds>> latencies(options.threads);
+    std::vector<std::chrono::nanoseconds> cpu(options.threads);
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    allocations = 0;
+
+    for (unsigned t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t] {
+            auto client = setup();
+            call(*client); // warm up: connection opened before measuring
+            auto share = calls / options.threads + (t < calls % options.threads ? 1 : 0);
+            latencies[t].reserve(share);
+            ++ready;
+            while (!go) { std::this_thread::yield(); }
+            count_allocations = true;
+            auto cpu_start = thread_cpu();
+            for (std::size_t i = 0; i < share; ++i) {
+                auto start = Clock::now();
+                call(*client);
+                latencies[t].push_back(Clock::now() - start);
+            }
+            cpu[t] = thread_cpu() - cpu_start;
+            count_allocations = false;
+        });
+    }
+    while (ready < options.threads) { std::this_thread::yield(); }
+    auto wire_start = wire ? wire->bytes_received() + wire->bytes_sent() : 0;
+    auto start = Clock::now();
+    go = true;
+    for (auto& thread : threads) { thread.join(); }
+
+    Result result;
+    result.seconds     = std::chrono::duration<double>(Clock::now() - start).count();
+    result.requests    = calls;
+    result.allocations = allocations;
+    result.cpu         = std::chrono::nanoseconds{0};
+    for (auto thread_cpu : cpu) { result.cpu += thread_cpu; }
+    result.wire_bytes  = wire ? wire->bytes_received() + wire->bytes_sent() - wire_start : 0;
+    for (auto& thread_latencies : latencies) {
+        result.latencies.insert(result.latencies.end(), thread_latencies.begin(), thread_latencies.end());
+    }
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+void report(const std::string& name, const Result& result, std::size_t requests_per_call = 1) {
+    auto percentile = [&result](double p) {
+        if (result.latencies.empty()) { return 0.0; }
+        auto index = std::min(result.latencies.size() - 1, static_cast<std::size_t>(p * result.latencies.size()));
+        return std::chrono::duration<double, std::micro>(result.latencies[index]).count();
+    };
+    auto http_requests = result.requests * requests_per_call;
+    std::cout << std::left << std::setw(30) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(0) << http_requests / result.seconds
+              << std::setw(11) << std::setprecision(1) << percentile(0.50)
+              << std::setw(11) << percentile(0.99)
+              << std::setw(11) << percentile(0.999)
+              << std::setw(13) << static_cast<double>(result.allocations) / http_requests
+              << std::setw(13) << std::chrono::duration<double, std::micro>(result.cpu).count() / http_requests
+              << std::setw(13) << std::setprecision(0) << static_cast<double>(result.wire_bytes) / http_requests << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        auto value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (flag == "--threads")       { options.threads  = static_cast<unsigned>(std::max(1ull, value)); }
+        else if (flag == "--requests") { options.requests = value; }
+        else if (flag == "--payload")  { options.payload  = value; }
+        else if (flag == "--users")    { options.users    = std::max(1ull, value); }
+        else if (flag == "--page")     { options.page     = std::max(1ull, value); }
+        else if (flag == "--latency")  { options.latency  = value; }
+        else if (flag == "--teams")    { options.teams    = std::max(1ull, value); }
+        else { std::cerr << "unknown option " << flag << '\n'; return 1; }
+    }
+
+    slack::MockOptions mock_options;
+    mock_options.users     = options.users;
+    mock_options.page_size = options.page;
+    slack::MockSlack mock{mock_options};
+    if (options.latency > 0) { mock.inject("*", slack::MockFault::delay(std::chrono::microseconds{options.latency})); }
+    mock.start();
+    wire = &mock;
+
+    auto make_client = [&mock] {
+        std::unique_ptr<slack::Slacking> client{new slack::Slacking{"xoxb-bench"}};
+        client->setBaseUrl(mock.url());
+        client->chat.channel = "C1000000";
+        client->hook.base_url = mock.hooks_url();
+        client->hook.Id = "T000/B000/XXXX";
+        return client;
+    };
+    const std::string text(options.payload, 'x');
+    const auto pages = (options.users + options.page - 1) / options.page;
+
+    std::cout << options.threads << " threads, " << options.requests << " requests per scenario, "
+              << options.payload << " bytes payload, " << options.users << " users in pages of " << options.page << "\n\n"
+              << std::left << std::setw(30) << "scenario" << std::right << std::setw(12) << "requests/s"
+              << std::setw(11) << "p50 us" << std::setw(11) << "p99 us" << std::setw(11) << "p99.9 us" << std::setw(13) << "allocs/req" << std::setw(13) << "cpu us/req"
+              << std::setw(13) << "bytes/req" << '\n';
+
+    report("Slacking::post", run(options, options.requests, make_client, [&text](slack::Slacking& client) {
+        client.post("chat.postMessage", slack::Json{{"channel", "C1000000"}, {"text", text}});
+    }));
+    report("Slacking::post in-memory", run(options, options.requests, [&mock] {
+        std::unique_ptr<slack::Slacking> client{new slack::Slacking{"xoxb-bench"}};
+        client->set_transport(mock.transport()); // no socket: what is left is the cost of the client and of the mock
+        return client;
+    }, [&text](slack::Slacking& client) {
+        client.post("chat.postMessage", slack::Json{{"channel", "C1000000"}, {"text", text}});
+    }));
+    report("chat.postMessage", run(options, options.requests, make_client, [&text](slack::Slacking& client) {
+        client.chat.postMessage(text);
+    }));
+    report("webhook postMessage", run(options, options.requests, make_client, [&text](slack::Slacking& client) {
+        client.hook.postMessage(text);
+    }));
+    // raw Json to a prebuilt url, unpaced: the cost of the client against hook.postMessage
+    slack::WebhookOptions webhook_options;
+    webhook_options.per_second = 0;
+    webhook_options.senders    = 1;
+    slack::WebhookClient webhooks{{mock.hooks_url() + "T000/B000/XXXX"}, webhook_options};
+    report("WebhookClient post", run(options, options.requests, [&webhooks] { return &webhooks; }, [&text](slack::WebhookClient& client) {
+        if (!client.post(slack::Json{{"text", text}})) { throw std::runtime_error("webhook failed"); }
+    }));
+    // many workspaces over few connections: each thread takes turns over its share of the teams of the pool
+    slack::PoolOptions pool_options;
+    pool_options.base_url         = mock.url();
+    pool_options.max_idle_handles = options.threads;
+    slack::SlackClientPool pool{pool_options};
+    for (std::size_t i = 0; i < options.teams; ++i) { pool.add("T" + std::to_string(i), "xoxb-bench"); }
+    struct Teams {
+        std::vector<slack::TeamClient*> clients;
+        std::size_t                     next{0};
+    };
+    std::atomic<unsigned> slice{0};
+    report("SlackClientPool " + std::to_string(options.teams) + " teams", run(options, options.requests, [&] {
+        std::unique_ptr<Teams> teams{new Teams};
+        for (auto i = slice++; i < options.teams; i += options.threads) { teams->clients.push_back(pool.find("T" + std::to_string(i))); }
+        if (teams->clients.empty()) { throw std::runtime_error("fewer teams than threads"); }
+        return teams;
+    }, [&text](Teams& teams) {
+        auto client = teams.clients[teams.next++ % teams.clients.size()];
+        client->slack.post("chat.postMessage", slack::Json{{"channel", "C1000000"}, {"text", text}});
+    }));
+    // one call reads every page: latency is per call, throughput and allocations per HTTP request
+    auto list_users = [&options](slack::Slacking& client) {
+        if (client.users.list_magic().size() != options.users) { throw std::runtime_error("users missing"); }
+    };
+    report("users.list_magic (per page)", run(options, std::max<std::size_t>(1, options.requests / pages), make_client, list_users), pages);
+    // the same pages gzipped by the mock: fewer bytes, decompressed by the client
+    report("users.list_magic gzip", run(options, std::max<std::size_t>(1, options.requests / pages), [&make_client] {
+        auto client = make_client();
+        client->set_accept_encoding();
+        return client;
+    }, list_users), pages);
+    // big Json bodies, as blocks: sent as is, then gzipped
+    slack::Json blocks = slack::Json::array();
+    for (std::size_t i = 0; blocks.dump().size() < options.payload * 64; ++i) {
+        blocks.push_back({{"type", "section"}, {"text", {{"type", "mrkdwn"}, {"text", "*Step " + std::to_string(i) + "* of build " + text.substr(0, 32) + ": passed in " + std::to_string(i * 37 % 1000) + " ms"}}}});
+    }
+    auto post_blocks = [&blocks](slack::Slacking& client) {
+        client.call(slack::methods::chat_postMessage, slack::Json{{"channel", "C1000000"}, {"text", "build"}, {"blocks", blocks}});
+    };
+    report("chat.postMessage blocks", run(options, options.requests, make_client, post_blocks));
+    report("chat.postMessage blocks gzip", run(options, options.requests, [&make_client] {
+        auto client = make_client();
+        slack::CompressionOptions compression;
+        compression.gzip_requests_above = 1024;
+        slack::enable_compression(*client, compression);
+        return client;
+    }, post_blocks));
+}
@@ -0,0 +1,129 @@
+// Web API traffic replayed from a trace file (trace.hpp), without network: time spent by Slacking on the answers
+// of each method, then Json DOM parsing against typed decoding of the users.list pages.
+//
+//     replay_bench [TRACE] [--rounds N] [--scale S] [--users N]
+//
+// Without TRACE, one is recorded first from the mock of slack.com (mock_server.hpp) with a large users.list.
+// Record a trace of your own with slack::record_to(slack, std::make_shared<slack::TraceRecorder>("prod.trace")).
+// --scale 1 replays each answer with its recorded latency, the default 0 measures the client alone.
+
+#include "slacking.hpp"
+#include "mock_server.hpp"
+#include "trace.hpp"
+
+#include <iomanip>
+#include <map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Totals {
+    std::size_t     calls{0};
+    std::size_t     errors{0};
+    std::uint64_t   bytes{0};
+    Clock::duration elapsed{};
+};
+
+void record_synthetic(const std::string& path, std::size_t users) {
+    slack::MockOptions options;
+    options.users     = users;
+    options.page_size = 1000;
+    options.channels  = 200;
+    options.messages  = 1000;
+    slack::MockSlack mock{options};
+    mock.start();
+
+    slack::Slacking slack{"xoxb-recorded"};
+    slack.setBaseUrl(mock.url());
+    slack::record_to(slack, std::make_shared<slack::TraceRecorder>(path));
+    slack.users.list_magic();
+    slack.conversations.list_magic();
+    for (int i = 0; i < 10; ++i) {
+        std::string cursor;
+        do {
+            slack::Json arguments = {{"channel", "C" + std::to_string(1000000 + i)}, {"limit", 200}};
+            if (!cursor.empty()) { arguments["cursor"] = cursor; }
+            auto page = slack.post("conversations.history", arguments);
+            cursor = page["response_metadata"].value("next_cursor", "");
+        } while (!cursor.empty());
+    }
+    for (int i = 0; i < 100; ++i) { slack.chat.postMessage("Deploy " + std::to_string(i) + " done", "C1000000"); }
+}
+
+double megabytes_per_second(std::uint64_t bytes, Clock::duration elapsed) {
+    return bytes / 1e6 / std::chrono::duration<double>(elapsed).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::size_t rounds = 5, users = 20000;
+    double scale = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--rounds" && i + 1 < argc)     { rounds = std::strtoul(argv[++i], nullptr, 10); }
+        else if (flag == "--scale" && i + 1 < argc) { scale  = std::strtod(argv[++i], nullptr); }
+        else if (flag == "--users" && i + 1 < argc) { users  = std::strtoul(argv[++i], nullptr, 10); }
+        else { path = flag; }
+    }
+    if (path.empty()) {
+        path = "replay_bench.trace";
+        record_synthetic(path, users);
+        std::cout << "recorded " << path << " from the mock server\n";
+    }
+
+    auto replayer = std::make_shared<slack::TraceReplayer>(path, slack::ReplayOptions{scale, false});
+    slack::Slacking slack{"xoxb-replayed", false};
+    slack::replay_from(slack, replayer);
+
+    std::map<std::string, Totals> methods;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        replayer->rewind();
+        for (auto const& exchange : replayer->exchanges()) {
+            auto api = exchange.url.find("/api/");
+            if (api == std::string::npos) { continue; } // webhooks
+            auto method = exchange.url.substr(api + 5);
+            auto& totals = methods[method];
+            auto start = Clock::now();
+            auto json = exchange.verb == "GET" ? slack.get(method, exchange.request_body) : slack.post(method, exchange.request_body);
+            totals.elapsed += Clock::now() - start;
+            totals.calls += 1;
+            totals.bytes += exchange.response_body.size();
+            if (!json.is_object() || !json.value("ok", false)) { totals.errors += 1; }
+        }
+    }
+
+    std::cout << replayer->exchanges().size() << " exchanges replayed " << rounds << " times\n\n";
+    std::cout << std::left << std::setw(26) << "method" << std::right << std::setw(8) << "calls" << std::setw(8) << "errors"
+              << std::setw(12) << "MB" << std::setw(12) << "us/call" << std::setw(10) << "MB/s" << '\n' << std::fixed;
+    for (auto const& entry : methods) {
+        auto const& t = entry.second;
+        std::cout << std::left << std::setw(26) << entry.first << std::right << std::setw(8) << t.calls << std::setw(8) << t.errors
+                  << std::setw(12) << std::setprecision(1) << t.bytes / 1e6
+                  << std::setw(12) << std::chrono::duration<double, std::micro>(t.elapsed).count() / t.calls
+                  << std::setw(10) << std::setprecision(0) << megabytes_per_second(t.bytes, t.elapsed) << '\n';
+    }
+
+    // the same users.list bodies, parsed into a Json DOM or decoded into slack::User
+    std::uint64_t bytes = 0;
+    std::size_t decoded = 0;
+    Clock::duration dom{}, typed{};
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto const& exchange : replayer->exchanges()) {
+            if (exchange.url.find("/users.list") == std::string::npos) { continue; }
+            bytes += exchange.response_body.size();
+            auto start = Clock::now();
+            auto json = slack::Json::parse(exchange.response_body);
+            dom += Clock::now() - start;
+            start = Clock::now();
+            decoded += slack::decode<slack::User>(exchange.response_body, "members").items.size();
+            typed += Clock::now() - start;
+        }
+    }
+    if (bytes > 0) {
+        std::cout << "\nusers.list bodies: Json::parse " << std::setprecision(0) << megabytes_per_second(bytes, dom)
+                  << " MB/s, decode<User> " << megabytes_per_second(bytes, typed) << " MB/s (" << decoded / rounds << " users)\n";
+    }
+}
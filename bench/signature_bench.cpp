@@ -0,0 +1,59 @@
+// Throughput of the request signature verification, in verifications per second on one core.
+// Compares SignatureVerifier (key schedule computed once) with a naive HMAC computed from scratch.
+
+#include "signature.hpp"
+
+#include <iomanip>
+
+namespace {
+
+std::string to_hex(const slack::Sha256::Digest& digest) {
+    std::ostringstream out;
+    for (auto byte : digest) { out << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte); }
+    return out.str();
+}
+
+// HMAC recomputed from the secret and compared as strings, as often done by hand
+bool naive_verify(const std::string& secret, const std::string& timestamp, const std::string& body, const std::string& signature) {
+    slack::HmacSha256 hmac{secret};
+    return "v0=" + to_hex(hmac.mac("v0:" + timestamp + ":" + body)) == signature;
+}
+
+template<typename F>
+double per_second(F verify) {
+    using Clock = std::chrono::steady_clock;
+    std::size_t count = 0;
+    bool all_valid = true;
+    auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (elapsed < std::chrono::seconds{1}) {
+        for (int i = 0; i < 1000; ++i) { all_valid = verify() && all_valid; }
+        count += 1000;
+        elapsed = Clock::now() - start;
+    }
+    if (!all_valid) { throw std::runtime_error("signature rejected"); }
+    return count / std::chrono::duration<double>(elapsed).count();
+}
+
+} // namespace
+
+int main() {
+    const std::string secret    = "8f742231b10e8888abcd99yyyzzz85a5";
+    const std::string timestamp = std::to_string(std::time(nullptr));
+    slack::SignatureVerifier verifier{secret};
+    slack::SignatureVerifier rotating{secret};
+    rotating.rotate("e2b1f4a93c5d8e7f6a0b1c2d3e4f5a6b"); // two active secrets, the request is signed with the previous one
+
+    std::cout << std::left << std::setw(12) << "body bytes" << std::setw(16) << "naive/s" << std::setw(16) << "verifier/s"
+              << std::setw(16) << "2 secrets/s" << '\n';
+    for (std::size_t size : {256u, 2048u, 16384u}) {
+        std::string body(size, 'x');
+        auto signature = "v0=" + to_hex(slack::HmacSha256{secret}.mac("v0:" + timestamp + ":" + body));
+
+        auto naive = per_second([&] { return naive_verify(secret, timestamp, body, signature); });
+        auto fast  = per_second([&] { return verifier.verify(timestamp, body, signature); });
+        auto both  = per_second([&] { return rotating.verify(timestamp, body, signature); });
+        std::cout << std::setw(12) << size << std::setw(16) << static_cast<long>(naive) << std::setw(16) << static_cast<long>(fast)
+                  << std::setw(16) << static_cast<long>(both) << '\n';
+    }
+}
@@ -59,6 +59,20 @@ void the_hard_way() {
 }
 
 
+// Thread safe: the message is a value, nothing of slack.chat is modified
+void the_builder_way() {
+    auto json_attachments = R"([
+        {
+            "fallback": "Built as a value!",
+            "text": "Built as a value!",
+            "color": "good"
+        }
+    ])"_json;
+
+    auto& slack = slack::instance();
+    slack.chat.post(slack.chat.message(" ", "#mychannel").with_username("Support Bot").with_icon_emoji(":hamster:")
+                                                          .with_attachments(json_attachments));
+}
 
 int main() {
     std::string mytoken;
@@ -69,5 +83,6 @@ int main() {
 
     the_slacking_way();
     the_hard_way();
+    the_builder_way();
 }
 
@@ -0,0 +1,29 @@
+#include "history_export.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    auto& slack = slack::create(mytoken);
+
+    // Export every channel the bot can see
+    std::vector<std::string> channel_ids;
+    for (auto const& channel : slack.conversations.list_magic()) {
+        channel_ids.push_back(channel.id);
+    }
+
+    slack::ExportOptions options;
+    options.directory       = ".";
+    options.checkpoint_file = "export.checkpoint"; // run it again to resume an interrupted export
+    options.workers         = 4;
+
+    slack::HistoryExporter exporter{mytoken, options};
+    auto stats = exporter.run(channel_ids);
+    std::cout << stats.messages << " messages and " << stats.replies << " replies exported in " << stats.pages << " pages\n";
+    for (auto const& channel : stats.failed_channels) {
+        std::cout << "failed: " << channel << '\n';
+    }
+}
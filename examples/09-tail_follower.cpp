@@ -0,0 +1,25 @@
+#include "tail_follower.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    slack::FollowerOptions options;
+    options.watermark_file = "watermarks.json"; // restart the program: messages already seen are not delivered again
+    options.min_interval   = std::chrono::seconds{2};
+    options.max_interval   = std::chrono::minutes{5};
+
+    slack::ChannelFollower follower{mytoken, [](const std::string& channel, const slack::Message& message) {
+        std::cout << channel << " [" << message.ts << "] " << message.user << ": " << message.text << '\n';
+    }, options};
+
+    follower.follow("C0123456789"); // channel ids to follow
+    follower.follow("C9876543210");
+
+    follower.start();
+    std::this_thread::sleep_for(std::chrono::minutes{10});
+    follower.stop();
+}
@@ -0,0 +1,29 @@
+#include "search_index.hpp"
+
+#include <ctime>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <index directory> <query> [export-000001.ndjson ...]\n";
+        return 1;
+    }
+
+    slack::SearchIndex index{argv[1]};
+
+    // Add the files written by a HistoryExporter (see 08-history_export.cpp)
+    for (int i = 3; i < argc; ++i) {
+        std::cout << index.add_ndjson(argv[i]) << " messages indexed from " << argv[i] << '\n';
+    }
+    index.commit(); // write the new messages as a segment
+    if (index.segment_count() > 8) {
+        index.compact();
+    }
+
+    // Messages of the last 30 days matching every word of the query, newest first
+    slack::SearchQuery query{argv[2]};
+    query.oldest = std::to_string(std::time(nullptr) - 30 * 24 * 3600);
+    query.limit  = 20;
+    for (auto const& hit : index.search(query)) {
+        std::cout << hit.channel << " [" << hit.ts << "] " << hit.user << ": " << hit.text << '\n';
+    }
+}
@@ -0,0 +1,37 @@
+#include "event_receiver.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    auto& slack = slack::create(mytoken);
+
+    // Point the Request URL of your Slack app Event Subscriptions to http://your-host:3000/slack/events
+    slack::ReceiverOptions options;
+    options.port    = 3000;
+    options.workers = 4;
+
+    slack::EventReceiver receiver{options};
+    receiver.set_verifier(std::make_shared<slack::SignatureVerifier>("your-signing-secret")); // from the Basic Information of your app
+    receiver.set_deduplicator(std::make_shared<slack::Deduplicator>()); // events retried by Slack are handled once
+
+    // Run on the worker pool: Slack has already been acknowledged, taking time here is fine
+    receiver.on_event([&slack](const slack::Json& payload) {
+        auto const& event = payload["event"];
+        if (event.value("type", "") == "app_mention") {
+            slack.chat.postMessage("You called me?", event.value("channel", ""));
+        }
+    });
+
+    receiver.route("/health", [](const slack::HttpRequest&) {
+        return slack::HttpResponse{200, "text/plain", "ok"};
+    }, false); // not called by Slack, so not signed
+
+    receiver.start();
+    std::cout << "Listening on port " << receiver.port() << std::endl;
+    std::this_thread::sleep_for(std::chrono::hours{24});
+    receiver.stop();
+}
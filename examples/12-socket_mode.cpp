@@ -0,0 +1,34 @@
+#include "socket_mode.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken, app_token;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+    std::getline(infile, app_token); // app-level token "xapp-..." with the connections:write scope
+
+    auto& slack = slack::create(mytoken);
+
+    // No public endpoint needed: enable Socket Mode in the settings of your Slack app
+    slack::SocketModeOptions options;
+    options.workers = 4;
+
+    slack::SocketModeClient client{app_token, options};
+
+    // Run on the worker pool: the envelope has already been acknowledged
+    client.on_envelope([&slack](const std::string& type, const slack::Json& envelope) {
+        auto const& payload = envelope["payload"];
+        if (type == "events_api" && payload["event"].value("type", "") == "app_mention") {
+            slack.chat.postMessage("You called me?", payload["event"].value("channel", ""));
+        }
+        else if (type == "slash_commands") {
+            slack.chat.postMessage("Command " + payload.value("command", "") + " received", payload.value("channel_id", ""));
+        }
+    });
+
+    client.start();
+    std::this_thread::sleep_for(std::chrono::hours{24});
+    client.stop();
+    std::cout << client.acked() << " envelopes acknowledged" << std::endl;
+}
@@ -0,0 +1,36 @@
+#include "event_dispatch.hpp"
+#include "socket_mode.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken, app_token;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+    std::getline(infile, app_token);
+
+    auto& slack = slack::create(mytoken);
+
+    // Handlers are registered per event structure, each structure only decodes the fields it declares
+    slack::EventDispatcher dispatcher;
+    dispatcher.on<slack::AppMention>([&slack](const slack::AppMention& mention) {
+        slack.chat.postMessage("You called me <@" + mention.user + ">?", mention.channel);
+    });
+    dispatcher.on<slack::ReactionAdded>([](const slack::ReactionAdded& reaction) {
+        std::cout << reaction.user << " reacted :" << reaction.reaction << ": to " << reaction.item_ts << '\n';
+    });
+    dispatcher.on<slack::MemberJoinedChannel>([&slack](const slack::MemberJoinedChannel& joined) {
+        slack.chat.postMessage("Welcome <@" + joined.user + ">!", joined.channel);
+    });
+    dispatcher.on_unhandled([](const slack::Json& event) {
+        std::cout << "no handler for " << event.value("type", "") << '\n';
+    });
+
+    // Works the same with slack::EventReceiver::on_event
+    slack::SocketModeClient client{app_token};
+    client.on_event([&dispatcher](const slack::Json& payload) { dispatcher.dispatch(payload); });
+
+    client.start();
+    std::this_thread::sleep_for(std::chrono::hours{24});
+    client.stop();
+}
@@ -0,0 +1,36 @@
+#include "interactivity.hpp"
+#include "socket_mode.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken, app_token;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+    std::getline(infile, app_token);
+
+    // Answers go through their own thread and connections, never behind other Web API calls
+    slack::ResponseLane lane{mytoken};
+    slack::Interactivity interactivity{lane};
+
+    // The command is acknowledged at once, the handler may take longer than the 3 seconds allowed by Slack
+    interactivity.on_command("/report", [](const slack::SlashCommand& command, const slack::Responder& responder) {
+        std::this_thread::sleep_for(std::chrono::seconds{5}); // e.g. a slow database query
+        responder.respond(slack::Json{{"response_type", "in_channel"}, {"text", "Report for " + command.text + " is ready"}});
+    });
+
+    interactivity.on_action("approve", [](const slack::Interaction& interaction, const slack::Responder& responder) {
+        responder.respond(slack::Json{{"replace_original", true}, {"text", "Approved by <@" + interaction.user_id + ">"}});
+    });
+
+    // With the Events API receiver (Linux), serve the Request URLs instead:
+    //     interactivity.attach(receiver); // /slack/commands and /slack/interactivity
+    slack::SocketModeClient client{app_token};
+    client.on_envelope([&interactivity](const std::string& type, const slack::Json& envelope) {
+        interactivity.handle_envelope(type, envelope);
+    });
+
+    client.start();
+    std::this_thread::sleep_for(std::chrono::hours{24});
+    client.stop();
+}
@@ -0,0 +1,33 @@
+#include "coroutine.hpp"
+
+#include <fstream>
+
+// Straight-line code, yet no thread is blocked while waiting for Slack
+slack::Task<> count_messages(slack::AsyncSlacking& slack, std::string channel) {
+    std::size_t count = 0;
+    std::string cursor;
+    do {
+        slack::Json arguments = {{"channel", channel}, {"limit", 200}};
+        if (!cursor.empty()) { arguments["cursor"] = cursor; }
+        auto page = co_await slack.post_co("conversations.history", arguments);
+        count += page["messages"].size();
+        cursor = page.count("response_metadata") ? page["response_metadata"].value("next_cursor", "") : "";
+    } while (!cursor.empty());
+
+    co_await slack.chat.postMessage_co(std::to_string(count) + " messages in this channel", channel);
+}
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    slack::CurlReactor reactor;
+    slack::AsyncSlacking slack{reactor, mytoken};
+
+    // Every channel is paged concurrently from this single thread
+    for (auto const& channel : {"C0123456789", "C0123456790", "C0123456791"}) {
+        reactor.spawn(count_messages(slack, channel));
+    }
+    reactor.run();
+}
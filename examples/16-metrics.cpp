@@ -0,0 +1,23 @@
+#include "metrics.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    auto& slack = slack::create(mytoken);
+
+    // Every call of slack, whatever the category method used, is now counted and timed
+    auto metrics = std::make_shared<slack::Metrics>();
+    slack.set_observer(metrics);
+
+    slack.api.test();
+    slack.chat.postMessage("Hello there!", "#testbot");
+    try { slack.chat.postMessage("Hello nobody", "#does-not-exist"); }
+    catch (std::exception&) {} // counted in slacking_error_codes_total{error="channel_not_found"}
+
+    // On Linux, slack::serve_metrics(receiver, metrics) serves the same text on /metrics of an EventReceiver
+    std::cout << metrics->render();
+}
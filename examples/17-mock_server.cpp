@@ -0,0 +1,69 @@
+#include "mock_server.hpp"
+#include "interactivity.hpp"
+
+int main() {
+    // A local slack.com with 250 users: no token, no network
+    slack::MockOptions options;
+    options.users = 250;
+    slack::MockSlack mock{options};
+
+    // A method the mock does not know, answered by a handler of ours
+    std::mutex mutex;
+    std::condition_variable updated;
+    slack::Json updated_view;
+    mock.on("views.update", [&](const slack::MockRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        updated_view = request.arguments["view"];
+        updated.notify_all();
+        return slack::Json{{"ok", true}, {"view", updated_view}};
+    });
+
+    // Or one replacing the generated pages: Slack's cursors hold '+', '/' and '=' which must come back as they were sent
+    const std::string cursor = "dXNl+cjpV/MDYx==";
+    mock.on("conversations.list", [&cursor](const slack::MockRequest& request) {
+        auto received = request.arguments.value("cursor", "");
+        if (!received.empty() && received != cursor) { return slack::Json{{"ok", false}, {"error", "invalid_cursor"}}; }
+        auto id = received.empty() ? "C1000000" : "C1000001";
+        return slack::Json{{"ok", true}, {"channels", {{{"id", id}, {"name", id}}}},
+                           {"response_metadata", {{"next_cursor", received.empty() ? cursor : ""}}}};
+    });
+    mock.start();
+
+    slack::Slacking slack{"xoxb-anything"};
+    slack.setBaseUrl(mock.url());
+    slack.hook.base_url = mock.hooks_url();
+    slack.hook.Id = "T000/B000/XXXX";
+
+    slack.chat.postMessage("Hello mock!", "C1000000");
+    slack.hook.postMessage("Hello webhook!");
+    std::cout << slack.users.list_magic().size() << " users read in " << mock.calls("users.list") << " pages\n";
+    auto channels = slack.conversations.list_magic();
+    std::cout << channels.size() << " channels read in " << mock.calls("conversations.list") << " pages\n";
+
+    // The next call is rate limited
+    mock.inject("chat.postMessage", slack::MockFault::ratelimited(2).only(1));
+    try { slack.chat.postMessage("Too fast", "C1000000"); }
+    catch (slack::RateLimited& e) { std::cout << "rate limited, retry after " << e.retry_after() << "s\n"; }
+
+    // One api.test out of two is reset, the other ones take 50 ms more
+    mock.inject("api.test", slack::MockFault::connection_reset().with_probability(0.5));
+    mock.inject("api.test", slack::MockFault::delay(std::chrono::milliseconds{50}));
+    for (int i = 0; i < 4; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            slack.api.test();
+            std::cout << "api.test answered in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+        }
+        catch (std::exception& e) { std::cout << "api.test failed: " << e.what() << '\n'; }
+    }
+
+    // The view of a modal updated from an interaction arrives as it was written
+    slack::Json view = {{"type", "modal"}, {"title", {{"type", "plain_text"}, {"text", "A & B + 100%"}}}};
+    slack::ResponseLane lane{"xoxb-anything"};
+    lane.setBaseUrl(mock.url());
+    lane.update_view({{"view_id", "V1000000"}, {"view", view}});
+    std::unique_lock<std::mutex> lock(mutex);
+    updated.wait_for(lock, std::chrono::seconds{5}, [&] { return !updated_view.is_null(); });
+    std::cout << "view " << (updated_view == view ? "updated intact: " : "altered: ") << updated_view.dump() << '\n';
+    return updated_view == view && channels.size() == 2 ? 0 : 1;
+}
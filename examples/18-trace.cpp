@@ -0,0 +1,25 @@
+#include "trace.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    // Record the real traffic: requests (token redacted), answers, headers and timing
+    {
+        slack::Slacking slack{mytoken};
+        auto recorder = std::make_shared<slack::TraceRecorder>("slack.trace");
+        slack::record_to(slack, recorder);
+        slack.api.test();
+        auto users = slack.users.list_magic();
+        std::cout << users.size() << " users, " << recorder->size() << " exchanges recorded\n";
+    }
+
+    // Replay it without network, twice faster than recorded
+    slack::Slacking offline{"xoxb-offline"};
+    slack::replay_from(offline, std::make_shared<slack::TraceReplayer>("slack.trace", slack::ReplayOptions{0.5, true}));
+    offline.api.test();
+    std::cout << offline.users.list_magic().size() << " users replayed\n";
+}
@@ -0,0 +1,29 @@
+#include "methods.hpp"
+
+#include <fstream>
+
+int main() {
+    std::string mytoken;
+    std::ifstream infile("token.txt");
+    std::getline(infile, mytoken);
+
+    auto& slack = slack::create(mytoken);
+
+    // Every call through the catalog is paced at the rate tier of its method
+    slack::RateLimiter limiter;
+    slack.set_rate_limiter(limiter);
+
+    slack.call(slack::methods::api_test);
+    auto posted = slack.call(slack::methods::chat_postMessage, {{"channel", "#general"}, {"text", "Sent with a method descriptor"}});
+    slack.call(slack::methods::reactions_add, {{"channel", posted["channel"]}, {"name", "tada"}, {"timestamp", posted["ts"]}});
+
+    // The arguments required by a method are checked before anything is sent
+    try { slack.call(slack::methods::chat_update, {{"channel", posted["channel"]}}); }
+    catch (std::exception& e) { std::cout << e.what() << '\n'; } // missing argument ts of chat.update
+
+    // Descriptors can be looked up by name, e.g. to give the right tier to a method called with post()
+    if (auto method = slack::methods::find("users.list")) {
+        limiter.acquire(method->name, method->tier);
+        std::cout << slack.post(method->name)["members"].size() << " users\n";
+    }
+}
@@ -0,0 +1,31 @@
+#include "client_pool.hpp"
+#include "methods.hpp"
+#include "metrics.hpp"
+
+#include <fstream>
+
+int main() {
+    // One line per installed workspace: team id then bot token
+    std::ifstream installations("installations.txt");
+
+    slack::SlackClientPool pool;
+    auto metrics = std::make_shared<slack::Metrics>();
+    pool.set_observer(metrics); // one set of metrics for every workspace
+
+    std::string team_id, token;
+    while (installations >> team_id >> token) {
+        auto& team = pool.add(team_id, token);
+        team.limiter.set_rate(slack::RateTier::Special, 60, 5); // each workspace has its own budget
+    }
+
+    // e.g. in the handler of an event: the team id picks the client without taking a lock
+    auto reply = [&pool](const std::string& team, const std::string& channel, const std::string& text) {
+        if (auto client = pool.find(team)) {
+            client->slack.call(slack::methods::chat_postMessage, {{"channel", channel}, {"text", text}});
+        }
+    };
+    if (pool.size() > 0) { reply(team_id, "#general", "Hello from the pool"); }
+
+    std::cout << pool.size() << " workspaces served by " << pool.transport()->idle() << " connections\n"
+              << metrics->render();
+}
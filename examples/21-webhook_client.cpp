@@ -0,0 +1,27 @@
+#include "webhook.hpp"
+
+#include <fstream>
+
+int main() {
+    // One incoming webhook url per line, all of them posting to the same channel
+    std::vector<std::string> urls;
+    std::ifstream infile("webhooks.txt");
+    for (std::string url; std::getline(infile, url); ) {
+        if (!url.empty()) { urls.push_back(url); }
+    }
+    if (urls.empty()) { std::cerr << "webhooks.txt lists no url\n"; return 1; }
+
+    slack::WebhookOptions options;
+    options.burst = 3; // each url may send 3 messages at once, then one per second
+    slack::WebhookClient alerts{urls, options};
+
+    // A burst of alerts: queued at once, sent as fast as the urls allow
+    for (int i = 0; i < 20; ++i) {
+        alerts.enqueue({{"text", "Alert #" + std::to_string(i) + ": disk usage above 90% on db-" + std::to_string(i % 4)}});
+    }
+    alerts.post({{"text", "Sent right away, on the url available first"}, {"icon_emoji", ":rotating_light:"}});
+
+    alerts.flush();
+    auto stats = alerts.stats();
+    std::cout << stats.sent << " sent, " << stats.retried << " retried, " << stats.failed << " failed\n";
+}
@@ -0,0 +1,30 @@
+#include "upload.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) { std::cerr << "usage: 22-upload FILE...\n"; return 1; }
+    auto& slack = slack::create("xxx-xxx");
+
+    slack::FileUploader uploader{slack, 2}; // two files sent at once
+    // the bytes uploaded by previous runs are shared again instead of uploaded
+    uploader.set_cache(std::make_shared<slack::UploadCache>("uploads.cache"));
+
+    slack::UploadOptions options;
+    options.channel_id      = "C0123456";
+    options.initial_comment = "Nightly build artifacts";
+    options.progress = [](const slack::UploadProgress& progress) {
+        if (progress.sent == progress.total) { std::cout << progress.filename << ": " << progress.total << " bytes sent\n"; }
+    };
+
+    std::vector<std::future<slack::UploadedFile>> uploads;
+    for (int i = 1; i < argc; ++i) { uploads.push_back(uploader.upload_async(argv[i], options)); }
+
+    for (auto& upload : uploads) {
+        try {
+            auto file = upload.get();
+            std::cout << file.title << (file.cached ? " shared again as " : " shared as ") << file.id << ": " << file.permalink << '\n';
+        }
+        catch (std::exception& e) {
+            std::cerr << e.what() << '\n';
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#include "download.hpp"
+#include "methods.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) { std::cerr << "usage: 23-download FILE_ID...\n"; return 1; }
+    const std::string token = "xxx-xxx"; // a bot token with the files:read scope
+    auto& slack = slack::create(token);
+
+    slack::DownloadOptions options;
+    options.connections = 8;       // over every file at once
+    options.chunk_bytes = 4 << 20; // bytes per range request
+    slack::FileDownloader downloader{token, options};
+
+    std::vector<std::future<slack::DownloadedFile>> downloads;
+    for (int i = 1; i < argc; ++i) {
+        auto file = slack.call(slack::methods::files_info, {{"file", argv[i]}})["file"];
+        downloads.push_back(downloader.download_async(file["url_private"].get<std::string>(),
+                                                      std::string{argv[i]} + '-' + file["name"].get<std::string>(),
+                                                      file["size"].get<std::uint64_t>()));
+    }
+
+    for (auto& download : downloads) {
+        try {
+            auto file = download.get();
+            std::cout << file.path << ": " << file.size << " bytes in " << file.requests << " requests\n";
+        }
+        catch (std::exception& e) {
+            std::cerr << e.what() << '\n';
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#include "compression.hpp"
+
+int main() {
+    auto& slack = slack::create("xxx-xxx");
+
+    // Big pages of users.list arrive gzipped, a few times smaller, and are decompressed as they are received
+    slack.set_accept_encoding();
+    auto users = slack.users.list_magic();
+    std::cout << users.size() << " users\n";
+
+    // Through a proxy which accepts compressed requests, the bodies of 4 KiB or more can be gzipped as well
+    slack::Slacking relayed{"xxx-xxx"};
+    relayed.set_proxy("http://relay.internal:3128");
+    slack::CompressionOptions options;
+    options.gzip_requests_above = 4096;
+    slack::enable_compression(relayed, options);
+
+    slack::Json blocks = slack::Json::array();
+    for (auto const& user : users) {
+        blocks.push_back({{"type", "section"}, {"text", {{"type", "mrkdwn"}, {"text", "Welcome <@" + user.id + ">!"}}}});
+        if (blocks.size() == 50) { break; } // Slack's limit per message
+    }
+    relayed.post("chat.postMessage", slack::Json{{"channel", "#general"}, {"text", "Welcome!"}, {"blocks", blocks.dump()}});
+}
@@ -0,0 +1,49 @@
+#include "mock_server.hpp"
+#include "socket_mode.hpp"
+
+// Wait up to 10 s for done()
+template<typename Predicate>
+bool wait_for(Predicate done) {
+    for (int i = 0; i < 1000 && !done(); ++i) { std::this_thread::sleep_for(std::chrono::milliseconds{10}); }
+    return done();
+}
+
+int main() {
+    // apps.connections.open of the mock hands out a WebSocket url of the mock itself
+    slack::MockSlack mock;
+    mock.start();
+
+    slack::SocketModeOptions options;
+    options.base_url = mock.url();
+    slack::SocketModeClient client{"xapp-anything", options};
+
+    std::atomic<int> handled{0};
+    client.on_event([&handled](const slack::Json& payload) {
+        std::cout << "event: " << payload["event"].value("text", "") << '\n';
+        ++handled;
+    });
+    client.start();
+
+    auto event = [](const std::string& text) { return slack::Json{{"event", {{"type", "message"}, {"text", text}}}}; };
+
+    // hello, then an envelope acknowledged by the client
+    auto first = mock.send_envelope("events_api", event("first"));
+    if (!wait_for([&] { return mock.acked(first); })) { std::cerr << "first envelope not acknowledged\n"; return 1; }
+
+    // Slack announces a disconnection: the client opens another connection before leaving this one
+    mock.disconnect_sockets();
+    if (!wait_for([&] { return mock.socket_connections() == 2; })) { std::cerr << "no new connection after disconnect\n"; return 1; }
+    auto second = mock.send_envelope("events_api", event("second"));
+    if (!wait_for([&] { return mock.acked(second); })) { std::cerr << "second envelope not acknowledged\n"; return 1; }
+
+    // The connection is lost: the client reconnects
+    mock.drop_sockets();
+    if (!wait_for([&] { return mock.socket_connections() == 3; })) { std::cerr << "no reconnection after a drop\n"; return 1; }
+    auto third = mock.send_envelope("events_api", event("third"));
+    if (!wait_for([&] { return mock.acked(third); })) { std::cerr << "third envelope not acknowledged\n"; return 1; }
+
+    client.stop();
+    std::cout << handled << " events handled over " << mock.socket_connections() << " connections, "
+              << client.acked() << " envelopes acknowledged" << std::endl;
+    return handled == 3 ? 0 : 1;
+}
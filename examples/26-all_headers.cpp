@@ -0,0 +1,32 @@
+// Every optional header in one translation unit: their names must not collide.
+// Built as C++11 and, when the compiler has it, as C++20 with the coroutine API too.
+#include "client_pool.hpp"
+#include "compression.hpp"
+#include "dedup.hpp"
+#include "download.hpp"
+#include "event_dispatch.hpp"
+#include "event_receiver.hpp"
+#include "history_export.hpp"
+#include "interactivity.hpp"
+#include "methods.hpp"
+#include "metrics.hpp"
+#include "mock_server.hpp"
+#include "search_index.hpp"
+#include "signature.hpp"
+#include "socket_mode.hpp"
+#include "tail_follower.hpp"
+#include "trace.hpp"
+#include "upload.hpp"
+#include "webhook.hpp"
+#if __cplusplus >= 202002L
+# include "coroutine.hpp"
+#endif
+
+int main() {
+    // The digest that keys the upload cache is the one the signatures are computed with
+    slack::Sha256 sha256;
+    sha256.update("abc");
+    auto digest = slack::_detail::hex_digest(sha256.finish());
+    std::cout << "sha256(abc) = " << digest << std::endl;
+    return digest == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: clients of many workspaces sharing their connections, metrics and DNS/TLS caches.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_CLIENT_POOL_HPP_
+#define SLACKING_CLIENT_POOL_HPP_
+
+#include "slacking.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+struct PoolOptions {
+    std::string base_url{};           // empty for https://slack.com/api/, e.g. the url of a MockSlack
+    std::string proxy_url{};
+    bool        throw_exception{true};
+    std::size_t max_idle_handles{16}; // connections kept alive between requests, shared by every team
+    std::size_t initial_capacity{64}; // teams held before the lookup table grows
+
+    PoolOptions() = default;
+};
+
+// The client of one workspace: its own token and rate budget (Slack limits apply per workspace), the transport
+// and the observer of the pool. slack.call() is paced by limiter.
+struct TeamClient {
+    TeamClient(const std::string& id, const std::string& token, const PoolOptions& options, std::shared_ptr<Transport> transport)
+        : team_id{id}, slack{token, options.throw_exception, transport} {
+        if (!options.base_url.empty()) { slack.setBaseUrl(options.base_url); }
+        slack.set_rate_limiter(limiter);
+    }
+
+    TeamClient(const TeamClient&)            = delete;
+    TeamClient& operator=(const TeamClient&) = delete;
+
+    const std::string team_id;
+    RateLimiter       limiter;
+    Slacking          slack;
+};
+
+// Clients of many workspaces keyed by team id, e.g. the installations of a Slack app:
+//
+//     slack::SlackClientPool pool;
+//     pool.add("T0001", token_of_T0001);
+//     pool.at(event["team_id"].get<std::string>()).slack.call(slack::methods::chat_postMessage, arguments);
+//
+// find() and at() take no lock: the table of teams is only written by add(), which publishes a new table when
+// it grows and keeps the old ones until the pool is destroyed, for the readers still walking them.
+// Teams stay in the pool as long as it lives. Many threads may call through the same TeamClient at once.
+class SlackClientPool {
+public:
+    explicit SlackClientPool(PoolOptions options = PoolOptions{})
+        : options_(options), transport_{std::make_shared<PooledCurlTransport>(options.max_idle_handles)} {
+        if (!options_.proxy_url.empty()) { transport_->set_proxy(options_.proxy_url); }
+        std::size_t capacity = 8;
+        while (capacity < options_.initial_capacity * 2) { capacity *= 2; }
+        tables_.emplace_back(new Table{capacity});
+        table_.store(tables_.back().get());
+    }
+
+    SlackClientPool(const SlackClientPool&)            = delete;
+    SlackClientPool& operator=(const SlackClientPool&) = delete;
+
+    // Client of team_id, created with token unless the team is known already
+    TeamClient& add(const std::string& team_id, const std::string& token);
+
+    // nullptr if the team was never added. Lock free.
+    TeamClient* find(const std::string& team_id) const {
+        auto table = table_.load(std::memory_order_acquire);
+        for (auto i = std::hash<std::string>{}(team_id) & table->mask; ; i = (i + 1) & table->mask) {
+            auto client = table->slots[i].load(std::memory_order_acquire);
+            if (!client || client->team_id == team_id) { return client; }
+        }
+    }
+
+    TeamClient& at(const std::string& team_id) const {
+        auto client = find(team_id);
+        if (!client) { throw std::runtime_error("[slacking] unknown team " + team_id); }
+        return *client;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return clients_.size();
+    }
+
+    // Observe the calls of every team, e.g. with one slack::Metrics. Set it before calling.
+    void set_observer(std::shared_ptr<CallObserver> observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        observer_ = observer;
+        for (auto& client : clients_) { client->slack.set_observer(observer_); }
+    }
+
+    // The transport shared by the teams, e.g. to send the requests of other Slacking instances through it
+    std::shared_ptr<PooledCurlTransport> transport() const { return transport_; }
+
+private:
+    // Open addressing, mask + 1 slots, never more than half full
+    struct Table {
+        explicit Table(std::size_t capacity) : mask{capacity - 1}, slots{new std::atomic<TeamClient*>[capacity]} {
+            for (std::size_t i = 0; i < capacity; ++i) { slots[i].store(nullptr, std::memory_order_relaxed); }
+        }
+        void insert(TeamClient* client) {
+            auto i = std::hash<std::string>{}(client->team_id) & mask;
+            while (slots[i].load(std::memory_order_relaxed)) { i = (i + 1) & mask; }
+            slots[i].store(client, std::memory_order_release);
+        }
+        std::size_t                               mask;
+        std::unique_ptr<std::atomic<TeamClient*>[]> slots;
+    };
+
+    PoolOptions                              options_;
+    std::shared_ptr<PooledCurlTransport>     transport_;
+    std::shared_ptr<CallObserver>            observer_;
+    mutable std::mutex                       mutex_;  // writers only
+    std::vector<std::unique_ptr<TeamClient>> clients_;
+    std::vector<std::unique_ptr<Table>>      tables_; // the current one last
+    std::atomic<Table*>                      table_{nullptr};
+};
+
+inline
+TeamClient& SlackClientPool::add(const std::string& team_id, const std::string& token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto known = find(team_id)) { return *known; }
+
+    std::unique_ptr<TeamClient> client{new TeamClient{team_id, token, options_, transport_}};
+    if (observer_) { client->slack.set_observer(observer_); }
+
+    auto table = tables_.back().get();
+    if ((clients_.size() + 1) * 2 > table->mask + 1) {
+        std::unique_ptr<Table> grown{new Table{(table->mask + 1) * 2}};
+        for (auto& existing : clients_) { grown->insert(existing.get()); }
+        tables_.push_back(std::move(grown));
+        table = tables_.back().get();
+        table_.store(table, std::memory_order_release);
+    }
+    table->insert(client.get());
+    clients_.push_back(std::move(client));
+    return *clients_.back();
+}
+
+} // namespace _detail
+
+using _detail::PoolOptions;
+using _detail::TeamClient;
+using _detail::SlackClientPool;
+
+} // namespace slack
+
+#endif // SLACKING_CLIENT_POOL_HPP_
@@ -0,0 +1,113 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: compressed answers and gzipped request bodies. Requires zlib (link with -lz).
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_COMPRESSION_HPP_
+#define SLACKING_COMPRESSION_HPP_
+
+#include "slacking.hpp"
+
+#include <memory>
+
+#include <zlib.h>
+
+namespace slack {
+
+namespace _detail {
+
+struct CompressionOptions {
+    bool        accept_encoding{true};  // compressed answers, decompressed by curl as they are received
+    std::size_t gzip_requests_above{0}; // bodies of this many bytes or more are sent gzipped, 0: never
+    int         level{Z_BEST_SPEED};    // of the requests, from 1 (fastest) to 9 (smallest)
+
+    CompressionOptions() = default;
+};
+
+// gzip format (RFC 1952) of size bytes at data
+inline
+std::string gzip(const char* data, std::size_t size, int level = Z_BEST_SPEED) {
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) { // 16: gzip header
+        throw std::runtime_error("[slacking] cannot compress. Reason: deflateInit2() failed");
+    }
+    std::string out(deflateBound(&stream, static_cast<uLong>(size)), '\0');
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in  = static_cast<uInt>(size);
+    stream.next_out  = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    auto res = deflate(&stream, Z_FINISH); // one pass: out is as large as deflate can need
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (res != Z_STREAM_END) { throw std::runtime_error("[slacking] cannot compress. Reason: deflate() returned " + std::to_string(res)); }
+    return out;
+}
+
+// Plain bytes of a gzip (or zlib) stream, false if it is not one or is truncated
+inline
+bool gunzip(const char* data, std::size_t size, std::string& out) {
+    z_stream stream{};
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) { return false; } // 32: gzip or zlib header, detected
+    stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    out.clear();
+    int res = Z_OK;
+    char chunk[16384];
+    while (res == Z_OK) {
+        stream.next_out  = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        res = inflate(&stream, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return res == Z_STREAM_END;
+}
+
+// Transport gzipping the bodies of gzip_above bytes or more before handing the requests to another transport.
+// Slack's Web API does not document compressed requests: meant for the proxies and the servers standing in for
+// Slack which accept them (MockSlack does), where big Json bodies (blocks, views) cost more bandwidth than CPU.
+class GzipTransport : public Transport {
+public:
+    GzipTransport(std::shared_ptr<Transport> transport, std::size_t gzip_above, int level = Z_BEST_SPEED)
+        : transport_{transport}, gzip_above_{std::max<std::size_t>(1, gzip_above)}, level_{level} {}
+
+    bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) override {
+        if (request.body.size < gzip_above_ || request.content_encoding.size > 0) { return transport_->perform(request, result, want_timing); }
+        auto body = gzip(request.body.data, request.body.size, level_);
+        auto compressed = request;
+        compressed.body             = BufferView{body};
+        compressed.content_encoding = BufferView{"gzip", 4};
+        return transport_->perform(compressed, result, want_timing);
+    }
+
+    void set_proxy(const std::string& url) override    { transport_->set_proxy(url); }
+    void set_accept_encoding(bool accept) override     { transport_->set_accept_encoding(accept); }
+    bool thread_safe() const override                  { return transport_->thread_safe(); }
+
+private:
+    std::shared_ptr<Transport> transport_;
+    std::size_t                gzip_above_;
+    int                        level_;
+};
+
+// Compress the traffic of slack as told by options, over the transport it has (set_transport() first if any)
+inline
+void enable_compression(Slacking& slack, CompressionOptions options = CompressionOptions{}) {
+    slack.set_accept_encoding(options.accept_encoding);
+    if (options.gzip_requests_above > 0) {
+        slack.set_transport(std::make_shared<GzipTransport>(slack.transport(), options.gzip_requests_above, options.level));
+    }
+}
+
+} // namespace _detail
+
+using _detail::CompressionOptions;
+using _detail::gzip;
+using _detail::gunzip;
+using _detail::GzipTransport;
+using _detail::enable_compression;
+
+} // namespace slack
+
+#endif // SLACKING_COMPRESSION_HPP_
@@ -0,0 +1,364 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: C++20 coroutine API driven by curl_multi (requires C++20).
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_COROUTINE_HPP_
+#define SLACKING_COROUTINE_HPP_
+
+#include "slacking.hpp"
+
+#if !(__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+# error "coroutine.hpp requires C++20, the rest of slacking only needs C++11"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace slack {
+
+namespace _detail {
+
+template<typename T = void>
+class Task;
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation{};
+    std::exception_ptr      error{};
+
+    // Tasks are lazy: they start when awaited or spawned
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value{};
+
+    Task<T> get_return_object();
+    template<typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T result() {
+        if (error) { std::rethrow_exception(error); }
+        return std::move(*value);
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+
+    void result() {
+        if (error) { std::rethrow_exception(error); }
+    }
+};
+
+// Lazy coroutine returning a T: co_await it from another task or hand it to CurlReactor::spawn()
+template<typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle       = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : handle_{handle} {}
+    Task(Task&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) { handle_.destroy(); }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() { if (handle_) { handle_.destroy(); } }
+
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle; // symmetric transfer: no stack growth along long chains of tasks
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    Handle handle_;
+};
+
+template<typename T>
+inline Task<T> TaskPromise<T>::get_return_object() { return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)}; }
+
+inline Task<void> TaskPromise<void>::get_return_object() { return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)}; }
+
+// HTTP exchange owned by the awaiting coroutine frame
+struct Transfer {
+    std::string             url;
+    std::string             body;
+    std::string             content_type{"application/x-www-form-urlencoded"};
+    std::string             response;
+    std::string             header;
+    long                    status_code{0};
+    CURLcode                result{CURLE_OK};
+    std::coroutine_handle<> waiter{};
+};
+
+// Event loop running many HTTP transfers on one thread with curl_multi. The coroutines awaiting the transfers
+// are resumed by run() as their transfer completes, so one thread holds thousands of concurrent calls.
+// Not thread safe: spawn tasks and run() from the same thread.
+class CurlReactor {
+public:
+    // max_connections bounds the connections opened by the reactor, 0 for no limit
+    explicit CurlReactor(long max_connections = 64) {
+        curl_global_init(CURL_GLOBAL_ALL);
+        multi_ = curl_multi_init();
+        curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS, max_connections);
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX); // share an HTTP/2 connection when possible
+    }
+
+    ~CurlReactor() {
+        for (auto easy : idle_) { curl_easy_cleanup(easy); }
+        curl_multi_cleanup(multi_);
+        curl_global_cleanup();
+    }
+
+    CurlReactor(const CurlReactor&)            = delete;
+    CurlReactor& operator=(const CurlReactor&) = delete;
+
+    void set_proxy(const std::string& url) { proxy_url_ = url; }
+
+    // co_await reactor.perform(transfer): POST transfer.body to transfer.url
+    auto perform(Transfer& transfer) {
+        struct Awaiter {
+            CurlReactor& reactor;
+            Transfer&    transfer;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> waiter) { transfer.waiter = waiter; reactor.add(transfer); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, transfer};
+    }
+
+    // Start a task now, up to its first suspension. run() drives it to its end.
+    void spawn(Task<void> task) {
+        ++active_;
+        launch(std::move(task), *this);
+    }
+
+    // Run the transfers until every spawned task has completed
+    void run() {
+        std::vector<Transfer*> completed;
+        while (active_ > 0 && in_flight_ > 0) {
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+
+            CURLMsg* message;
+            int left = 0;
+            while ((message = curl_multi_info_read(multi_, &left))) {
+                if (message->msg != CURLMSG_DONE) { continue; }
+                auto easy = message->easy_handle;
+                Transfer* transfer = nullptr;
+                curl_easy_getinfo(easy, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+                transfer->result = message->data.result;
+                curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &transfer->status_code);
+                curl_multi_remove_handle(multi_, easy);
+                idle_.push_back(easy);
+                --in_flight_;
+                completed.push_back(transfer);
+            }
+            // resumed coroutines may start new transfers, never while reading the messages of curl
+            for (auto transfer : completed) { transfer->waiter.resume(); }
+            completed.clear();
+
+            if (in_flight_ > 0 && running > 0) { curl_multi_poll(multi_, nullptr, 0, 1000, nullptr); }
+        }
+    }
+
+    std::size_t in_flight() const { return in_flight_; }
+
+private:
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept {}
+        };
+    };
+
+    static Detached launch(Task<void> task, CurlReactor& reactor) {
+        try { co_await std::move(task); }
+        catch (std::exception& e) { std::cerr << "[slacking] task failed. Reason: " << e.what() << '\n'; }
+        --reactor.active_;
+    }
+
+    static size_t writeFunction(char* ptr, size_t size, size_t nmemb, std::string* data) {
+        data->append(ptr, size * nmemb);
+        return size * nmemb;
+    }
+
+    void add(Transfer& transfer) {
+        CURL* easy;
+        if (!idle_.empty()) { easy = idle_.back(); idle_.pop_back(); curl_easy_reset(easy); }
+        else { easy = curl_easy_init(); }
+
+        auto& headers = headers_[transfer.content_type];
+        if (!headers) { headers.reset(curl_slist_append(nullptr, ("Content-Type: " + transfer.content_type).c_str()), curl_slist_free_all); }
+
+        curl_easy_setopt(easy, CURLOPT_URL, transfer.url.c_str());
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer.body.size()));
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, transfer.body.data());
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.get());
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeFunction);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer.response);
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, writeFunction);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer.header);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        if (!proxy_url_.empty()) { curl_easy_setopt(easy, CURLOPT_PROXY, proxy_url_.c_str()); }
+        curl_multi_add_handle(multi_, easy);
+        ++in_flight_;
+    }
+
+    CURLM*             multi_;
+    std::vector<CURL*> idle_;        // finished handles, reused to keep their connection and DNS caches
+    std::map<std::string, std::shared_ptr<curl_slist>> headers_;
+    std::string        proxy_url_;
+    std::size_t        in_flight_{0};
+    std::size_t        active_{0};
+};
+
+// Web API client whose calls are coroutines:
+//
+//     slack::Task<> hello(slack::AsyncSlacking& slack) {
+//         auto json = co_await slack.chat.postMessage_co("Hello", "#general");
+//     }
+//
+// Errors are reported by exceptions, as with Slacking: RateLimited on HTTP 429 and std::runtime_error otherwise.
+class AsyncSlacking {
+public:
+    AsyncSlacking(CurlReactor& reactor, const std::string& token) : reactor_(reactor), token_{token} {}
+
+    AsyncSlacking(const AsyncSlacking&)            = delete;
+    AsyncSlacking& operator=(const AsyncSlacking&) = delete;
+
+    void setBaseUrl(const std::string& url) { base_url_ = url; }
+    std::string getBaseUrl() const { return base_url_; }
+
+    // Arguments are taken by value: the task may start after the caller's temporaries are gone
+    Task<Json> post_co(std::string method, std::string data) {
+        Transfer transfer;
+        transfer.url  = base_url_ + method;
+        transfer.body = std::move(data);
+        co_await reactor_.perform(transfer);
+
+        if (transfer.result != CURLE_OK) {
+            throw std::runtime_error("curl_easy_perform() failed " + std::string{curl_easy_strerror(transfer.result)});
+        }
+        if (transfer.status_code == 429) {
+            throw RateLimited{Session::retryAfter(transfer.header)};
+        }
+        auto json = Json::parse(transfer.response, nullptr, false);
+        if (json.is_discarded()) { co_return Json{}; }
+        if (json.count("ok") && !json["ok"].is_null() && !json.value("ok", false)) {
+            throw std::runtime_error(json.count("error") ? json["error"].dump() : "checkResponse() unknown error.");
+        }
+        co_return json;
+    }
+
+    // A body already form encoded, as a literal: post_co("api.test", "foo=bar") is not taken for a Json
+    Task<Json> post_co(std::string method, const char* data) {
+        return post_co(std::move(method), std::string{data});
+    }
+
+    // Every value is escaped, as Slacking::call() does
+    Task<Json> post_co(std::string method, Json json) {
+        auto data = formEncode(json);
+        data += (data.empty() ? "token=" : "&token=") + easyEscape(token_);
+        return post_co(std::move(method), std::move(data));
+    }
+
+    std::string easyEscape(const std::string& text) {
+        char* encoded = curl_easy_escape(nullptr, text.c_str(), static_cast<int>(text.length()));
+        std::string escaped{encoded};
+        curl_free(encoded);
+        return escaped;
+    }
+
+    std::string formEncode(const Json& arguments) {
+        std::string data;
+        if (!arguments.is_object()) { return data; }
+        for (auto it = arguments.begin(); it != arguments.end(); ++it) {
+            if (!data.empty()) { data += '&'; }
+            data += it.key();
+            data += '=';
+            data += easyEscape(it->is_string() ? it->get<std::string>() : it->dump());
+        }
+        return data;
+    }
+
+    struct CategoryChat {
+        std::string channel{};
+        std::string username{};
+        std::string icon_emoji{};
+        std::string parse{};
+
+        // Same arguments as Slacking::chat.postMessage
+        Task<Json> postMessage_co(const std::string& text, const std::string& specified_channel = "") {
+            auto str_channel = specified_channel.empty() ? channel : specified_channel;
+            if (str_channel.empty()) { throw std::runtime_error("channel is not set"); }
+            Json json_arguments = {
+                { "text"       , text           },
+                { "channel"    , str_channel    },
+                { "username"   , username       },
+                { "icon_emoji" , icon_emoji     },
+                { "parse"      , parse          }
+            };
+            return slack_.post_co("chat.postMessage", std::move(json_arguments));
+        }
+
+        explicit CategoryChat(AsyncSlacking& slack) : slack_(slack) {}
+        AsyncSlacking& slack_;
+    };
+
+    CategoryChat chat{*this};
+
+private:
+    CurlReactor& reactor_;
+    std::string  token_;
+    std::string  base_url_{"https://slack.com/api/"};
+};
+
+} // namespace _detail
+
+using _detail::Task;
+using _detail::CurlReactor;
+using _detail::AsyncSlacking;
+
+} // namespace slack
+
+#endif // SLACKING_COROUTINE_HPP_
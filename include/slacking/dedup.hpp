@@ -0,0 +1,173 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: de-duplication of the events delivered again by Slack.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_DEDUP_HPP_
+#define SLACKING_DEDUP_HPP_
+
+#include "slacking.hpp"
+
+#include <cmath>
+
+namespace slack {
+
+namespace _detail {
+
+struct DedupOptions {
+    std::size_t          capacity{100000};            // distinct ids expected per window
+    double               false_positive_rate{1e-4};   // chance that a new id is taken for a duplicate
+    std::chrono::seconds window{3600};                // ids are remembered between one and two windows
+
+    DedupOptions() = default;
+    DedupOptions(std::size_t c, double p, std::chrono::seconds w) : capacity{c}, false_positive_rate{p}, window{w} {}
+};
+
+// Remember the ids of the events already handled (event_id of the Events API, envelope_id of Socket Mode)
+// to drop the deliveries Slack retries when the ack was late (X-Slack-Retry-Num).
+// Two Bloom filters are used in turn: ids are inserted in the current one and looked up in both, and the
+// older one is cleared and becomes the current one after a window or once the current one holds capacity ids.
+// Memory is fixed at construction: about 2 * 1.44 * log2(2 / false_positive_rate) bits per id of capacity.
+// A new id is taken for a duplicate with probability false_positive_rate at most, a duplicate is never missed
+// within a window, as long as fewer than capacity ids arrive per window: more rotate the filters sooner.
+// Safe to share between threads.
+class Deduplicator {
+public:
+    explicit Deduplicator(DedupOptions options = DedupOptions{}) : options_(options) {
+        auto n = static_cast<double>(std::max<std::size_t>(1, options_.capacity));
+        auto p = std::min(0.5, std::max(1e-12, options_.false_positive_rate)) / 2; // an id is looked up in both filters
+        auto ln2 = std::log(2.0);
+        auto bits = std::ceil(-n * std::log(p) / (ln2 * ln2));
+        words_  = static_cast<std::size_t>(std::ceil(bits / 64));
+        hashes_ = std::max(1u, static_cast<unsigned>(std::lround(bits / n * ln2)));
+        for (auto& filter : filters_) { filter.bits.assign(words_, 0); }
+        rotated_at_ = std::chrono::steady_clock::now();
+    }
+
+    // Test and insert: true if id was seen already. Two threads seeing the same id: only one gets false.
+    bool seen(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rotateIfDue();
+        auto erased = erased_.find(id);
+        if (erased == erased_.end() && lookup(id)) { return true; }
+        if (erased != erased_.end()) { erased_.erase(erased); }
+        add(id);
+        return false;
+    }
+
+    // Undo seen() for an id which could not be handled, e.g. its event was refused: the retry is not a duplicate.
+    // A Bloom filter cannot clear the bits of one id, so it is kept aside until they are rotated out.
+    void erase(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        erased_[id] = rotations_;
+    }
+
+    bool contains(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rotateIfDue();
+        return erased_.find(id) == erased_.end() && lookup(id);
+    }
+
+    void insert(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rotateIfDue();
+        if (!lookup(id)) { add(id); }
+    }
+
+    std::size_t memory_bytes() const { return 2 * words_ * sizeof(std::uint64_t); }
+
+private:
+    struct Filter {
+        std::vector<std::uint64_t> bits;
+        std::size_t                count{0};
+    };
+
+    // FNV-1a then two mixes of it give the two hashes of the Kirsch-Mitzenmacher double hashing
+    static void hash(const std::string& id, std::uint64_t& h1, std::uint64_t& h2) {
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : id) { h = (h ^ c) * 0x100000001b3ull; }
+        auto mix = [](std::uint64_t x) {
+            x ^= x >> 33; x *= 0xff51afd7ed558ccdull;
+            x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ull;
+            return x ^ (x >> 33);
+        };
+        h1 = mix(h);
+        h2 = mix(h ^ 0x9e3779b97f4a7c15ull) | 1;
+    }
+
+    bool test(const Filter& filter, std::uint64_t h1, std::uint64_t h2) const {
+        auto size = words_ * 64;
+        for (unsigned i = 0; i < hashes_; ++i) {
+            auto bit = (h1 + i * h2) % size;
+            if (!(filter.bits[bit / 64] & (1ull << (bit % 64)))) { return false; }
+        }
+        return true;
+    }
+
+    bool lookup(const std::string& id) const {
+        std::uint64_t h1, h2;
+        hash(id, h1, h2);
+        return test(filters_[current_], h1, h2) || test(filters_[1 - current_], h1, h2);
+    }
+
+    void add(const std::string& id) {
+        std::uint64_t h1, h2;
+        hash(id, h1, h2);
+        auto& filter = filters_[current_];
+        auto size = words_ * 64;
+        for (unsigned i = 0; i < hashes_; ++i) {
+            auto bit = (h1 + i * h2) % size;
+            filter.bits[bit / 64] |= 1ull << (bit % 64);
+        }
+        ++filter.count;
+    }
+
+    void rotateIfDue() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - rotated_at_ < options_.window && filters_[current_].count < options_.capacity) { return; }
+        current_ = 1 - current_;
+        std::fill(filters_[current_].bits.begin(), filters_[current_].bits.end(), 0);
+        filters_[current_].count = 0;
+        rotated_at_ = now;
+        ++rotations_;
+        for (auto it = erased_.begin(); it != erased_.end();) { // cleared from both filters by now
+            if (rotations_ - it->second >= 2) { it = erased_.erase(it); } else { ++it; }
+        }
+    }
+
+    DedupOptions  options_;
+    std::size_t   words_;
+    unsigned      hashes_;
+    Filter        filters_[2];
+    unsigned      current_{0};
+    std::chrono::steady_clock::time_point rotated_at_;
+    std::uint64_t rotations_{0};
+    std::unordered_map<std::string, std::uint64_t> erased_; // id erased, at rotation
+    std::mutex    mutex_;
+};
+
+// Id to de-duplicate a payload on: event_id of an Events API callback, else envelope_id of a Socket Mode envelope
+inline
+std::string dedup_key(const Json& payload) {
+    auto event_id = payload.find("event_id");
+    if (event_id != payload.end() && event_id->is_string()) { return event_id->get<std::string>(); }
+    auto inner = payload.find("payload");
+    if (inner != payload.end() && inner->is_object()) {
+        event_id = inner->find("event_id");
+        if (event_id != inner->end() && event_id->is_string()) { return event_id->get<std::string>(); }
+    }
+    auto envelope_id = payload.find("envelope_id");
+    if (envelope_id != payload.end() && envelope_id->is_string()) { return envelope_id->get<std::string>(); }
+    return "";
+}
+
+} // namespace _detail
+
+using _detail::DedupOptions;
+using _detail::Deduplicator;
+using _detail::dedup_key;
+
+} // namespace slack
+
+#endif // SLACKING_DEDUP_HPP_
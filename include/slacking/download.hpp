@@ -0,0 +1,372 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: download of private files (url_private) to disk, in ranges fetched in parallel.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_DOWNLOAD_HPP_
+#define SLACKING_DOWNLOAD_HPP_
+
+#include "slacking.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace slack {
+
+namespace _detail {
+
+struct DownloadOptions {
+    unsigned      connections{8};       // range requests in flight at once, over every download of the downloader
+    std::uint64_t chunk_bytes{8 << 20}; // bytes per range request
+    unsigned      max_retries{3};       // per range, on 429, 5xx or no answer
+
+    DownloadOptions() = default;
+};
+
+struct DownloadedFile {
+    std::string   path;
+    std::uint64_t size{0};
+    unsigned      requests{0}; // ranges fetched, retries included
+};
+
+// Download of the files shared on Slack, given their url_private (files.info, or the files of a message),
+// authenticated with the bot token (files:read scope). A file is fetched in ranges of chunk_bytes by concurrent
+// requests, each written where it belongs in the file with pwrite(): nothing is buffered in memory.
+//
+//     slack::FileDownloader downloader{token};
+//     auto archived = downloader.download_async(file["url_private"].get<std::string>(), "archive/" + name, file["size"].get<std::uint64_t>());
+//
+// The first range tells the size of the file, which is then allocated at once and split between the threads
+// of the downloader: connections bounds the requests in flight over all the downloads, so one downloader should
+// serve the whole process. The file is written to path.part, its size checked against the Content-Range of the
+// answers and against the size expected if given, then renamed to path. Failures are thrown, or set in the future,
+// as std::runtime_error; the partial file is removed. The destructor waits for the downloads queued. POSIX only.
+class FileDownloader {
+public:
+    explicit FileDownloader(const std::string& token, DownloadOptions options = DownloadOptions{})
+        : authorization_{"Authorization: Bearer " + token}, options_(options),
+          queue_{std::numeric_limits<std::size_t>::max()} { // never blocks: the workers themselves queue ranges
+        options_.chunk_bytes = std::max<std::uint64_t>(1, options_.chunk_bytes);
+        curl_global_init(CURL_GLOBAL_ALL);
+        for (unsigned i = 0; i < std::max(1u, options_.connections); ++i) { workers_.emplace_back([this] { work(); }); }
+    }
+
+    ~FileDownloader() {
+        queue_.close();
+        for (auto& worker : workers_) { worker.join(); }
+        curl_global_cleanup();
+    }
+
+    FileDownloader(const FileDownloader&)            = delete;
+    FileDownloader& operator=(const FileDownloader&) = delete;
+
+    // expected_size: the size given by Slack for the file, 0 when unknown
+    DownloadedFile download(const std::string& url, const std::string& path, std::uint64_t expected_size = 0) {
+        return download_async(url, path, expected_size).get();
+    }
+
+    std::future<DownloadedFile> download_async(const std::string& url, const std::string& path, std::uint64_t expected_size = 0);
+
+private:
+    struct Job {
+        std::string                  url;
+        std::string                  path;
+        std::uint64_t                expected{0};
+        std::uint64_t                total{0};    // known once the first range is answered
+        int                          fd{-1};
+        std::atomic<unsigned>        pending{0};  // ranges queued or being fetched
+        std::atomic<unsigned>        requests{0};
+        std::atomic<bool>            failed{false};
+        std::mutex                   mutex;       // error
+        std::string                  error;
+        std::promise<DownloadedFile> promise;
+    };
+
+    // length 0 for the first range of a file, which also accepts the whole file from a server ignoring ranges
+    struct Range {
+        Range() = default;
+        Range(std::shared_ptr<Job> j, std::uint64_t o, std::uint64_t l) : job{j}, offset{o}, length{l} {}
+
+        std::shared_ptr<Job> job;
+        std::uint64_t        offset{0};
+        std::uint64_t        length{0};
+    };
+
+    // Where the body of one answer goes
+    struct Sink {
+        Sink(CURL* c, int f, std::uint64_t o, std::uint64_t l, bool w) : curl{c}, fd{f}, offset{o}, limit{l}, whole_accepted{w} {}
+
+        CURL*         curl;
+        int           fd;
+        std::uint64_t offset;
+        std::uint64_t limit;
+        bool          whole_accepted;
+        long          status{0};
+        bool          html{false};
+        bool          refused{false};  // not written: an error or login page, or the whole file instead of a range
+        std::string   refusal;         // its first bytes
+        std::uint64_t written{0};
+        bool          overflow{false}; // more bytes than asked for
+        int           write_errno{0};
+    };
+
+    void work();
+    void fetch(CURL* curl, const Range& range);
+    void fail(Job& job, const std::string& reason);
+    void done(const std::shared_ptr<Job>& job);
+
+    std::string part(const Job& job) const { return job.path + ".part"; }
+
+    void queueRanges(const std::shared_ptr<Job>& job, std::uint64_t from) {
+        unsigned count = 0;
+        for (auto offset = from; offset < job->total; offset += options_.chunk_bytes) { ++count; }
+        job->pending += count;
+        for (auto offset = from; offset < job->total; offset += options_.chunk_bytes) {
+            queue_.push(Range{job, offset, std::min(options_.chunk_bytes, job->total - offset)});
+        }
+    }
+
+    static int preallocate(int fd, std::uint64_t size) {
+#if defined(__linux__)
+        if (size > 0 && ::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) { return 0; }
+#endif
+        return ::ftruncate(fd, static_cast<off_t>(size)); // sparse, where the file system cannot allocate
+    }
+
+    // "Content-Range: bytes first-last/total" of the headers, false if absent
+    static bool contentRange(const std::string& headers, std::uint64_t& first, std::uint64_t& last, std::uint64_t& total) {
+        std::string lower{headers};
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        auto field = lower.rfind("\ncontent-range:");
+        if (field == std::string::npos) { return false; }
+        auto value = lower.c_str() + field + 15;
+        while (*value == ' ') { ++value; }
+        if (std::strncmp(value, "bytes ", 6) != 0) { return false; }
+        value += 6;
+        char* end = nullptr;
+        if (*value == '*') { // unsatisfied range: "bytes */total"
+            first = 1;
+            last  = 0;
+            end   = const_cast<char*>(value + 1);
+        }
+        else {
+            first = std::strtoull(value, &end, 10);
+            if (*end != '-') { return false; }
+            last = std::strtoull(end + 1, &end, 10);
+        }
+        if (*end != '/') { return false; }
+        total = std::strtoull(end + 1, &end, 10);
+        return true;
+    }
+
+    static size_t writeFunction(char* data, size_t size, size_t nmemb, void* userdata) {
+        auto& sink = *static_cast<Sink*>(userdata);
+        auto bytes = size * nmemb;
+        if (sink.status == 0) { // first bytes of the body: what is it?
+            curl_easy_getinfo(sink.curl, CURLINFO_RESPONSE_CODE, &sink.status);
+            char* content_type = nullptr;
+            curl_easy_getinfo(sink.curl, CURLINFO_CONTENT_TYPE, &content_type);
+            sink.html    = (sink.status == 200 || sink.status == 206) && content_type && std::strncmp(content_type, "text/html", 9) == 0; // login page
+            sink.refused = sink.html || (sink.status != 206 && !(sink.status == 200 && sink.whole_accepted));
+        }
+        if (sink.refused) {
+            sink.refusal.append(data, std::min(bytes, 256 - std::min<std::size_t>(256, sink.refusal.size())));
+            return bytes;
+        }
+        if (bytes > sink.limit - sink.written) {
+            sink.overflow = true;
+            return 0;
+        }
+
+        for (size_t done = 0; done < bytes; ) {
+            auto n = ::pwrite(sink.fd, data + done, bytes - done, static_cast<off_t>(sink.offset + sink.written + done));
+            if (n < 0) {
+                if (errno == EINTR) { continue; }
+                sink.write_errno = errno;
+                return 0;
+            }
+            done += static_cast<size_t>(n);
+        }
+        sink.written += bytes;
+        return bytes;
+    }
+
+    static size_t headerFunction(char* data, size_t size, size_t nmemb, std::string* headers) {
+        if (headers->compare(0, 5, "HTTP/") == 0 && std::strncmp(data, "HTTP/", 5) == 0) { headers->clear(); } // redirected or 100 Continue
+        headers->append(data, size * nmemb);
+        return size * nmemb;
+    }
+
+    std::string              authorization_;
+    DownloadOptions          options_;
+    BlockingQueue<Range>     queue_;
+    std::vector<std::thread> workers_;
+};
+
+inline
+std::future<DownloadedFile> FileDownloader::download_async(const std::string& url, const std::string& path, std::uint64_t expected_size) {
+    auto job = std::make_shared<Job>();
+    job->url      = url;
+    job->path     = path;
+    job->expected = expected_size;
+    auto result = job->promise.get_future();
+
+    job->fd = ::open(part(*job).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (job->fd < 0) { throw std::runtime_error("[slacking] cannot write " + part(*job) + ": " + std::strerror(errno)); }
+    if (expected_size > 0 && preallocate(job->fd, expected_size) != 0) {
+        auto reason = std::string{std::strerror(errno)};
+        ::close(job->fd);
+        ::unlink(part(*job).c_str());
+        throw std::runtime_error("[slacking] cannot allocate " + std::to_string(expected_size) + " bytes for " + part(*job) + ": " + reason);
+    }
+    job->pending = 1;
+    if (!queue_.push(Range{job, 0, 0})) { throw std::runtime_error("[slacking] downloader stopped"); }
+    return result;
+}
+
+inline
+void FileDownloader::work() {
+    auto curl = curl_easy_init();
+    Range range;
+    while (queue_.pop(range)) {
+        auto job = range.job;
+        if (!curl) { fail(*job, "curl_easy_init() failed"); }
+        else if (!job->failed) { fetch(curl, range); }
+        range = Range{};
+        done(job);
+    }
+    if (curl) { curl_easy_cleanup(curl); }
+}
+
+// One range of a file, retried on 429, 5xx or no answer
+inline
+void FileDownloader::fetch(CURL* curl, const Range& range) {
+    auto& job = *range.job;
+    bool first_range = range.length == 0;
+    auto length = first_range ? options_.chunk_bytes : range.length;
+    auto bytes = std::to_string(range.offset) + '-' + std::to_string(range.offset + length - 1);
+
+    for (unsigned attempt = 0; ; ++attempt) {
+        ++job.requests;
+        Sink sink(curl, job.fd, range.offset, first_range ? std::numeric_limits<std::uint64_t>::max() : length, first_range);
+        std::string headers;
+        curl_header header(curl);
+        header.append(authorization_);
+
+        curl_easy_setopt(curl, CURLOPT_URL, job.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl, CURLOPT_RANGE, bytes.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header.list());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // without the Authorization header to another host
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerFunction);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers);
+
+        auto res = curl_easy_perform(curl);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr); // the list is freed with header
+        curl_easy_setopt(curl, CURLOPT_RANGE, nullptr);
+        long status = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+
+        std::uint64_t first = 0, last = 0, total = 0;
+        bool has_range = contentRange(headers, first, last, total);
+        if (res == CURLE_OK && status == 416 && first_range && has_range && total == 0) { // empty file
+            job.total = 0;
+        }
+        else if (res == CURLE_OK && !sink.refused && (status == 206 || status == 200)) {
+            if (status == 206 && (!has_range || first != range.offset || last - first + 1 != sink.written)) {
+                fail(job, "range " + bytes + " answered with " + std::to_string(sink.written) + " bytes");
+                return;
+            }
+            if (!first_range) { return; }
+            job.total = status == 206 ? total : sink.written;
+        }
+        else {
+            std::string reason;
+            bool retryable = false;
+            if (sink.write_errno != 0) { reason = "cannot write " + part(job) + ": " + std::strerror(sink.write_errno); }
+            else if (sink.overflow)    { reason = "range " + bytes + " answered with more bytes than asked for"; }
+            else if (sink.html)        { reason = "answered with a page instead of the file: is the token allowed files:read?"; }
+            else if (res != CURLE_OK)  { reason = curl_easy_strerror(res); retryable = true; }
+            else if (status == 200)    { reason = "range " + bytes + " answered with the whole file"; }
+            else {
+                reason = "range " + bytes + " answered " + std::to_string(status) + ' ' + sink.refusal;
+                retryable = status == 429 || status >= 500;
+            }
+            if (!retryable || attempt >= options_.max_retries) {
+                fail(job, reason);
+                return;
+            }
+            auto delay = status == 429 ? std::chrono::milliseconds{1000 * std::max(1l, Session::retryAfter(headers))}
+                                       : std::chrono::milliseconds{100 << attempt};
+            std::this_thread::sleep_for(delay);
+            continue;
+        }
+
+        // first range: the size of the file is known, the rest is split between the workers
+        if (job.expected > 0 && job.total != job.expected) {
+            fail(job, "size " + std::to_string(job.total) + " instead of the " + std::to_string(job.expected) + " bytes expected");
+            return;
+        }
+        if (job.expected == 0 && job.total > sink.written && preallocate(job.fd, job.total) != 0) {
+            fail(job, "cannot allocate " + std::to_string(job.total) + " bytes: " + std::strerror(errno));
+            return;
+        }
+        queueRanges(range.job, sink.written);
+        return;
+    }
+}
+
+inline
+void FileDownloader::fail(Job& job, const std::string& reason) {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    if (job.error.empty()) { job.error = reason; }
+    job.failed = true;
+}
+
+// Once the last range of a file is fetched: check its size then publish it under its name
+inline
+void FileDownloader::done(const std::shared_ptr<Job>& job) {
+    if (--job->pending > 0) { return; }
+
+    struct stat written;
+    if (!job->failed && (::fstat(job->fd, &written) != 0 || static_cast<std::uint64_t>(written.st_size) != job->total)) {
+        fail(*job, "size on disk differs from the " + std::to_string(job->total) + " bytes received");
+    }
+    if (::close(job->fd) != 0 && !job->failed) { fail(*job, "cannot write " + part(*job) + ": " + std::strerror(errno)); }
+    if (!job->failed && std::rename(part(*job).c_str(), job->path.c_str()) != 0) {
+        fail(*job, "cannot rename " + part(*job) + " to " + job->path + ": " + std::strerror(errno));
+    }
+    if (job->failed) {
+        ::unlink(part(*job).c_str());
+        job->promise.set_exception(std::make_exception_ptr(std::runtime_error("[slacking] download of " + job->url + " failed. Reason: " + job->error)));
+        return;
+    }
+    DownloadedFile file;
+    file.path     = job->path;
+    file.size     = job->total;
+    file.requests = job->requests;
+    job->promise.set_value(file);
+}
+
+} // namespace _detail
+
+using _detail::DownloadOptions;
+using _detail::DownloadedFile;
+using _detail::FileDownloader;
+
+} // namespace slack
+
+#endif // SLACKING_DOWNLOAD_HPP_
@@ -0,0 +1,232 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: typed dispatch of Events API payloads.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_EVENT_DISPATCH_HPP_
+#define SLACKING_EVENT_DISPATCH_HPP_
+
+#include "slacking.hpp"
+
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+// An event structure gives its Events API type with type() and the fields it needs with fields(),
+// the same bindings as the typed decoding of Web API responses (see Message::fields()).
+
+struct MessageEvent {
+    std::string subtype;
+    std::string channel;
+    std::string channel_type;
+    std::string user;
+    std::string bot_id;
+    std::string text;
+    std::string ts;
+    std::string thread_ts;
+
+    static const char* type() { return "message"; }
+    static const std::vector<FieldBinding<MessageEvent>>& fields() {
+        static const std::vector<FieldBinding<MessageEvent>> bindings = {
+            field("subtype", &MessageEvent::subtype), field("channel", &MessageEvent::channel),
+            field("channel_type", &MessageEvent::channel_type), field("user", &MessageEvent::user),
+            field("bot_id", &MessageEvent::bot_id), field("text", &MessageEvent::text),
+            field("ts", &MessageEvent::ts), field("thread_ts", &MessageEvent::thread_ts)
+        };
+        return bindings;
+    }
+};
+
+struct AppMention {
+    std::string channel;
+    std::string user;
+    std::string text;
+    std::string ts;
+    std::string thread_ts;
+
+    static const char* type() { return "app_mention"; }
+    static const std::vector<FieldBinding<AppMention>>& fields() {
+        static const std::vector<FieldBinding<AppMention>> bindings = {
+            field("channel", &AppMention::channel), field("user", &AppMention::user), field("text", &AppMention::text),
+            field("ts", &AppMention::ts), field("thread_ts", &AppMention::thread_ts)
+        };
+        return bindings;
+    }
+};
+
+struct ReactionAdded {
+    std::string user;
+    std::string reaction;
+    std::string item_user;
+    std::string item_type;
+    std::string item_channel;
+    std::string item_ts;
+    std::string event_ts;
+
+    static const char* type() { return "reaction_added"; }
+    static const std::vector<FieldBinding<ReactionAdded>>& fields() {
+        static const std::vector<FieldBinding<ReactionAdded>> bindings = {
+            field("user", &ReactionAdded::user), field("reaction", &ReactionAdded::reaction),
+            field("item_user", &ReactionAdded::item_user), field("item.type", &ReactionAdded::item_type),
+            field("item.channel", &ReactionAdded::item_channel), field("item.ts", &ReactionAdded::item_ts),
+            field("event_ts", &ReactionAdded::event_ts)
+        };
+        return bindings;
+    }
+};
+
+struct MemberJoinedChannel {
+    std::string user;
+    std::string channel;
+    std::string channel_type;
+    std::string inviter;
+
+    static const char* type() { return "member_joined_channel"; }
+    static const std::vector<FieldBinding<MemberJoinedChannel>>& fields() {
+        static const std::vector<FieldBinding<MemberJoinedChannel>> bindings = {
+            field("user", &MemberJoinedChannel::user), field("channel", &MemberJoinedChannel::channel),
+            field("channel_type", &MemberJoinedChannel::channel_type), field("inviter", &MemberJoinedChannel::inviter)
+        };
+        return bindings;
+    }
+};
+
+// Dotted paths of T::fields() split once into keys
+template<typename T>
+const std::vector<std::vector<std::string>>& field_keys() {
+    static const std::vector<std::vector<std::string>> keys = [] {
+        std::vector<std::vector<std::string>> split;
+        for (auto const& binding : T::fields()) {
+            std::vector<std::string> path;
+            std::size_t begin = 0, dot;
+            while ((dot = binding.path.find('.', begin)) != std::string::npos) {
+                path.push_back(binding.path.substr(begin, dot - begin));
+                begin = dot + 1;
+            }
+            path.push_back(binding.path.substr(begin));
+            split.push_back(std::move(path));
+        }
+        return split;
+    }();
+    return keys;
+}
+
+// Fill the bound fields of item from a Json object: one lookup per bound key, the other members are not read
+template<typename T>
+void decode_fields(const Json& object, T& item) {
+    auto const& bindings = T::fields();
+    auto const& keys = field_keys<T>();
+    for (std::size_t i = 0; i < bindings.size(); ++i) {
+        const Json* value = &object;
+        for (auto const& key : keys[i]) {
+            if (!value->is_object()) { value = nullptr; break; }
+            auto it = value->find(key);
+            if (it == value->end()) { value = nullptr; break; }
+            value = &*it;
+        }
+        if (!value) { continue; }
+
+        auto const& binding = bindings[i];
+        switch (binding.kind) {
+        case FieldBinding<T>::Kind::String:
+            if (value->is_string()) { item.*(binding.string_member) = value->template get<std::string>(); }
+            break;
+        case FieldBinding<T>::Kind::Bool:
+            if (value->is_boolean()) { item.*(binding.bool_member) = value->template get<bool>(); }
+            break;
+        case FieldBinding<T>::Kind::Unsigned:
+            if (value->is_number()) { item.*(binding.unsigned_member) = value->template get<unsigned>(); }
+            break;
+        case FieldBinding<T>::Kind::UInt64:
+            if (value->is_number()) { item.*(binding.uint64_member) = value->template get<std::uint64_t>(); }
+            break;
+        case FieldBinding<T>::Kind::Double:
+            if (value->is_number()) { item.*(binding.double_member) = value->template get<double>(); }
+            break;
+        }
+    }
+}
+
+// Route Events API payloads to handlers registered per event structure:
+//
+//     dispatcher.on<slack::ReactionAdded>([](const slack::ReactionAdded& reaction) { ... });
+//
+// A payload costs one hash lookup on its event type whatever the number of handlers, and its event is decoded
+// once per registered structure, reading only the fields that structure binds. Register the handlers before
+// dispatching: dispatch() is then safe to call from many threads.
+class EventDispatcher {
+public:
+    template<typename T, typename Handler>
+    void on(Handler handler) {
+        auto& slots = routes_[T::type()];
+        for (auto& slot : slots) {
+            if (slot->tag() == tag<T>()) {
+                static_cast<TypedSlot<T>&>(*slot).handlers.emplace_back(handler);
+                return;
+            }
+        }
+        std::unique_ptr<TypedSlot<T>> slot{new TypedSlot<T>};
+        slot->handlers.emplace_back(handler);
+        slots.push_back(std::move(slot));
+    }
+
+    // Called with the raw event when no handler is registered for its type
+    void on_unhandled(std::function<void(const Json& event)> handler) { unhandled_ = handler; }
+
+    // Accept an Events API payload (with "event") or the event itself. Return false if no handler took it.
+    bool dispatch(const Json& payload) const {
+        auto event_it = payload.find("event");
+        auto const& event = event_it != payload.end() ? *event_it : payload;
+        auto type_it = event.find("type");
+        if (type_it == event.end() || !type_it->is_string()) { return false; }
+
+        auto route = routes_.find(type_it->get_ref<const std::string&>());
+        if (route == routes_.end()) {
+            if (unhandled_) { unhandled_(event); }
+            return false;
+        }
+        for (auto const& slot : route->second) { slot->dispatch(event); }
+        return true;
+    }
+
+private:
+    struct Slot {
+        virtual ~Slot() = default;
+        virtual const void* tag() const = 0;
+        virtual void dispatch(const Json& event) const = 0;
+    };
+
+    template<typename T>
+    static const void* tag() { static const char unique = 0; return &unique; }
+
+    template<typename T>
+    struct TypedSlot : Slot {
+        std::vector<std::function<void(const T&)>> handlers;
+
+        const void* tag() const override { return EventDispatcher::tag<T>(); }
+        void dispatch(const Json& event) const override {
+            T decoded;
+            decode_fields(event, decoded);
+            for (auto const& handler : handlers) { handler(decoded); }
+        }
+    };
+
+    std::unordered_map<std::string, std::vector<std::unique_ptr<Slot>>> routes_;
+    std::function<void(const Json&)> unhandled_;
+};
+
+} // namespace _detail
+
+using _detail::MessageEvent;
+using _detail::AppMention;
+using _detail::ReactionAdded;
+using _detail::MemberJoinedChannel;
+using _detail::decode_fields;
+using _detail::EventDispatcher;
+
+} // namespace slack
+
+#endif // SLACKING_EVENT_DISPATCH_HPP_
@@ -0,0 +1,477 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: embedded HTTP receiver for the Events API (Linux only, epoll).
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_EVENT_RECEIVER_HPP_
+#define SLACKING_EVENT_RECEIVER_HPP_
+
+#include "slacking.hpp"
+#include "dedup.hpp"
+#include "signature.hpp"
+
+#if !defined(__linux__)
+# error "event_receiver.hpp relies on epoll and is only available on Linux"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace slack {
+
+namespace _detail {
+
+struct HttpRequest {
+    std::string method;
+    std::string target;
+    std::string version;
+    std::vector<std::pair<std::string, std::string>> headers; // names in lower case
+    std::string body;
+
+    std::string header(const std::string& lower_name) const {
+        for (auto const& h : headers) {
+            if (h.first == lower_name) { return h.second; }
+        }
+        return "";
+    }
+
+    // target without its query string
+    std::string path() const { return target.substr(0, target.find('?')); }
+};
+
+struct HttpResponse {
+    int         status;
+    std::string content_type;
+    std::string body;
+
+    HttpResponse(int s = 200, const std::string& c = "text/plain", const std::string& b = "") : status{s}, content_type{c}, body{b} {}
+};
+
+inline
+const char* http_reason(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+    }
+}
+
+struct ReceiverOptions {
+    std::string    address{"0.0.0.0"};
+    unsigned short port{3000};              // 0: any free port, see EventReceiver::port()
+    unsigned       acceptors{2};            // event loops, each with its own SO_REUSEPORT socket
+    unsigned       workers{4};              // threads running the event handlers
+    std::size_t    queue_capacity{1024};    // events waiting for a worker, above it Slack is answered 503 and retries later
+    std::size_t    max_body_bytes{1u << 20};
+    std::chrono::seconds keep_alive{60};
+    std::string    events_path{"/slack/events"};
+};
+
+// Small HTTP/1.1 server receiving the Events API requests.
+// Each acceptor thread runs its own epoll loop on its own SO_REUSEPORT listening socket, so the kernel spreads
+// the connections between them. url_verification is answered at once and event callbacks are parsed into Json,
+// queued to a bounded worker pool and acknowledged right away: slow handlers never delay the 3 seconds ack.
+class EventReceiver {
+public:
+    using EventHandler = std::function<void(const Json& payload)>;
+    using RouteHandler = std::function<HttpResponse(const HttpRequest& request)>;
+
+    explicit EventReceiver(ReceiverOptions options = ReceiverOptions{}) : options_(options) {}
+    ~EventReceiver() { stop(); }
+
+    EventReceiver(const EventReceiver&)            = delete;
+    EventReceiver& operator=(const EventReceiver&) = delete;
+
+    // Handler of the event callbacks, run by the worker pool. Set it before start().
+    void on_event(EventHandler handler) { event_handler_ = handler; }
+
+    // Handler of any other path, run by the acceptor thread: it must answer quickly and
+    // hand slow work to submit(). Set the routes before start().
+    // Routes which are not called by Slack (e.g. health checks) are not verified.
+    void route(const std::string& path, RouteHandler handler, bool from_slack = true) { routes_[path] = Route{handler, from_slack}; }
+
+    // Reject with 401 the requests from Slack whose signature is not valid. Set it before start().
+    void set_verifier(std::shared_ptr<SignatureVerifier> verifier) { verifier_ = verifier; }
+
+    // Acknowledge without handling the event callbacks already handled. Set it before start().
+    void set_deduplicator(std::shared_ptr<Deduplicator> deduplicator) { deduplicator_ = deduplicator; }
+
+    // Run a task on the worker pool, false if the pool is saturated
+    bool submit(std::function<void()> task) { return pool_ && pool_->submit(std::move(task)); }
+
+    void start();
+    void stop();
+
+    unsigned short port() const { return bound_port_; }
+
+private:
+    struct Route {
+        RouteHandler handler;
+        bool         from_slack;
+    };
+
+    struct Connection {
+        std::string in;
+        std::string out;
+        std::size_t out_offset{0};
+        bool        close_after_write{false};
+        std::chrono::steady_clock::time_point last_activity{};
+    };
+
+    struct Loop {
+        int epoll_fd{-1};
+        int listen_fd{-1};
+        int wake_fd{-1};
+        std::map<int, Connection> connections;
+        std::thread thread;
+    };
+
+    int  listenSocket(unsigned short port);
+    void run(Loop& loop);
+    void acceptAll(Loop& loop);
+    void readFrom(Loop& loop, int fd, Connection& connection);
+    void writeTo(Loop& loop, int fd, Connection& connection);
+    void closeConnection(Loop& loop, int fd);
+    bool parseRequest(Connection& connection, HttpRequest& request, HttpResponse& error);
+    HttpResponse handle(const HttpRequest& request);
+    bool verified(const HttpRequest& request) const;
+    HttpResponse handleEvent(const HttpRequest& request);
+    void queueResponse(Connection& connection, const HttpResponse& response, bool keep_alive);
+
+    ReceiverOptions                       options_;
+    EventHandler                          event_handler_;
+    std::map<std::string, Route>          routes_;
+    std::shared_ptr<SignatureVerifier>    verifier_;
+    std::shared_ptr<Deduplicator>         deduplicator_;
+    std::unique_ptr<WorkerPool>           pool_;
+    std::vector<std::unique_ptr<Loop>>    loops_;
+    std::atomic<bool>                     stopping_{false};
+    unsigned short                        bound_port_{0};
+};
+
+inline
+int EventReceiver::listenSocket(unsigned short port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { throw std::runtime_error(std::string{"[slacking] socket() failed "} + std::strerror(errno)); }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(port);
+    if (::inet_pton(AF_INET, options_.address.c_str(), &address.sin_addr) != 1) {
+        ::close(fd);
+        throw std::runtime_error("[slacking] invalid listening address " + options_.address);
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        auto reason = std::string{std::strerror(errno)};
+        ::close(fd);
+        throw std::runtime_error("[slacking] cannot listen on " + options_.address + ':' + std::to_string(port) + ' ' + reason);
+    }
+    return fd;
+}
+
+inline
+void EventReceiver::start() {
+    if (!loops_.empty()) { return; }
+    stopping_ = false;
+    pool_.reset(new WorkerPool{options_.workers, options_.queue_capacity});
+
+    bound_port_ = options_.port;
+    try {
+        for (unsigned i = 0; i < std::max(1u, options_.acceptors); ++i) {
+            loops_.push_back(std::unique_ptr<Loop>{new Loop}); // in loops_ at once: closed below if the next calls fail
+            auto& loop = *loops_.back();
+            loop.listen_fd = listenSocket(bound_port_);
+            if (bound_port_ == 0) { // the other acceptors share the port picked for the first one
+                sockaddr_in address{};
+                socklen_t length = sizeof(address);
+                ::getsockname(loop.listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+                bound_port_ = ntohs(address.sin_port);
+            }
+            loop.epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (loop.epoll_fd < 0) { throw std::runtime_error(std::string{"[slacking] epoll_create1() failed "} + std::strerror(errno)); }
+            loop.wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (loop.wake_fd < 0) { throw std::runtime_error(std::string{"[slacking] eventfd() failed "} + std::strerror(errno)); }
+            epoll_event event{};
+            event.events  = EPOLLIN;
+            event.data.fd = loop.listen_fd;
+            ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, loop.listen_fd, &event);
+            event.data.fd = loop.wake_fd;
+            ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, loop.wake_fd, &event);
+        }
+    }
+    catch (...) {
+        for (auto& loop : loops_) {
+            if (loop->listen_fd >= 0) { ::close(loop->listen_fd); }
+            if (loop->wake_fd >= 0)   { ::close(loop->wake_fd); }
+            if (loop->epoll_fd >= 0)  { ::close(loop->epoll_fd); }
+        }
+        loops_.clear();
+        pool_.reset();
+        throw;
+    }
+    for (auto& loop : loops_) {
+        auto raw = loop.get();
+        loop->thread = std::thread([this, raw] { run(*raw); });
+    }
+}
+
+inline
+void EventReceiver::stop() {
+    if (loops_.empty()) { return; }
+    stopping_ = true;
+    for (auto& loop : loops_) {
+        std::uint64_t one = 1;
+        auto written = ::write(loop->wake_fd, &one, sizeof(one));
+        ignore_unused_parameter(written);
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) { loop->thread.join(); }
+        for (auto& connection : loop->connections) { ::close(connection.first); }
+        ::close(loop->listen_fd);
+        ::close(loop->wake_fd);
+        ::close(loop->epoll_fd);
+    }
+    loops_.clear();
+    pool_->shutdown(); // events already acknowledged are still handled
+    pool_.reset();
+}
+
+inline
+void EventReceiver::run(Loop& loop) {
+    epoll_event events[64];
+    auto last_sweep = std::chrono::steady_clock::now();
+    while (!stopping_) {
+        int count = ::epoll_wait(loop.epoll_fd, events, 64, 1000);
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == loop.wake_fd) { continue; }
+            if (fd == loop.listen_fd) { acceptAll(loop); continue; }
+            auto it = loop.connections.find(fd);
+            if (it == loop.connections.end()) { continue; }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) { closeConnection(loop, fd); continue; }
+            if (events[i].events & EPOLLIN)  { readFrom(loop, fd, it->second); }
+            it = loop.connections.find(fd);
+            if (it != loop.connections.end() && (events[i].events & EPOLLOUT)) { writeTo(loop, fd, it->second); }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep > std::chrono::seconds{1}) {
+            last_sweep = now;
+            std::vector<int> idle;
+            for (auto const& connection : loop.connections) {
+                if (now - connection.second.last_activity > options_.keep_alive) { idle.push_back(connection.first); }
+            }
+            for (auto fd : idle) { closeConnection(loop, fd); }
+        }
+    }
+}
+
+inline
+void EventReceiver::acceptAll(Loop& loop) {
+    for (;;) {
+        int fd = ::accept4(loop.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) { return; } // EAGAIN: nothing more to accept
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        epoll_event event{};
+        event.events  = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        loop.connections[fd].last_activity = std::chrono::steady_clock::now();
+    }
+}
+
+inline
+void EventReceiver::readFrom(Loop& loop, int fd, Connection& connection) {
+    char buffer[16384];
+    bool peer_closed = false;
+    for (;;) {
+        auto n = ::read(fd, buffer, sizeof(buffer));
+        if (n > 0) { connection.in.append(buffer, static_cast<std::size_t>(n)); continue; }
+        if (n == 0) { peer_closed = true; break; } // the requests already received are still answered
+        if (errno != EAGAIN && errno != EWOULDBLOCK) { closeConnection(loop, fd); return; }
+        break;
+    }
+    connection.last_activity = std::chrono::steady_clock::now();
+
+    // pipelined requests are answered in order
+    HttpRequest request;
+    HttpResponse error;
+    while (!connection.close_after_write && parseRequest(connection, request, error)) {
+        if (error.status != 200) {
+            queueResponse(connection, error, false);
+            break;
+        }
+        auto keep_alive = request.version == "HTTP/1.1" ? request.header("connection") != "close"
+                                                        : request.header("connection") == "keep-alive";
+        queueResponse(connection, handle(request), keep_alive);
+    }
+    if (peer_closed) { connection.close_after_write = true; }
+    writeTo(loop, fd, connection);
+}
+
+inline
+void EventReceiver::writeTo(Loop& loop, int fd, Connection& connection) {
+    while (connection.out_offset < connection.out.size()) {
+        auto n = ::send(fd, connection.out.data() + connection.out_offset, connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+            closeConnection(loop, fd);
+            return;
+        }
+        connection.out_offset += static_cast<std::size_t>(n);
+    }
+
+    bool pending = connection.out_offset < connection.out.size();
+    if (!pending) {
+        connection.out.clear();
+        connection.out_offset = 0;
+        if (connection.close_after_write) { closeConnection(loop, fd); return; }
+    }
+    epoll_event event{};
+    event.events  = EPOLLIN | EPOLLRDHUP | (pending ? EPOLLOUT : 0u);
+    event.data.fd = fd;
+    ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+inline
+void EventReceiver::closeConnection(Loop& loop, int fd) {
+    ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    loop.connections.erase(fd);
+}
+
+// Extract the first complete request of the connection buffer. False if more bytes are needed.
+// On a malformed request, error.status is set to the status to answer before closing.
+inline
+bool EventReceiver::parseRequest(Connection& connection, HttpRequest& request, HttpResponse& error) {
+    error = HttpResponse{200};
+    auto header_end = connection.in.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        if (connection.in.size() > 65536) { error = HttpResponse{413}; return true; }
+        return false;
+    }
+
+    request = HttpRequest{};
+    std::istringstream stream{connection.in.substr(0, header_end)};
+    std::string line;
+    std::getline(stream, line);
+    if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+    std::istringstream request_line{line};
+    request_line >> request.method >> request.target >> request.version;
+    if (request.version.compare(0, 5, "HTTP/") != 0) { error = HttpResponse{400}; return true; }
+
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        auto colon = line.find(':');
+        if (colon == std::string::npos) { continue; }
+        auto name  = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        auto value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        request.headers.emplace_back(std::move(name), std::move(value));
+    }
+
+    if (!request.header("transfer-encoding").empty()) { error = HttpResponse{501}; return true; }
+    auto content_length = request.header("content-length");
+    std::size_t length = content_length.empty() ? 0 : std::strtoul(content_length.c_str(), nullptr, 10);
+    if (length > options_.max_body_bytes) { error = HttpResponse{413}; return true; }
+    if (connection.in.size() < header_end + 4 + length) { return false; }
+
+    request.body = connection.in.substr(header_end + 4, length);
+    connection.in.erase(0, header_end + 4 + length);
+    return true;
+}
+
+inline
+HttpResponse EventReceiver::handle(const HttpRequest& request) {
+    auto path = request.path();
+    try {
+        if (path == options_.events_path) { return verified(request) ? handleEvent(request) : HttpResponse{401}; }
+        auto route = routes_.find(path);
+        if (route != routes_.end()) {
+            if (route->second.from_slack && !verified(request)) { return HttpResponse{401}; }
+            return route->second.handler(request);
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "[slacking] " << request.method << ' ' << path << " failed. Reason: " << e.what() << '\n';
+        return HttpResponse{500};
+    }
+    return HttpResponse{404};
+}
+
+inline
+bool EventReceiver::verified(const HttpRequest& request) const {
+    return !verifier_ || verifier_->verify(request.header("x-slack-request-timestamp"), request.body, request.header("x-slack-signature"));
+}
+
+inline
+HttpResponse EventReceiver::handleEvent(const HttpRequest& request) {
+    if (request.method != "POST") { return HttpResponse{405}; }
+    auto payload = std::make_shared<Json>(Json::parse(request.body, nullptr, false));
+    if (payload->is_discarded() || !payload->is_object()) { return HttpResponse{400}; }
+
+    if (payload->value("type", "") == "url_verification") {
+        return HttpResponse{200, "application/json", Json{{"challenge", payload->value("challenge", "")}}.dump()};
+    }
+    if (!event_handler_) { return HttpResponse{200}; }
+
+    // tested and remembered at once: two loops given the same retried event do not both queue it
+    auto key = deduplicator_ ? dedup_key(*payload) : std::string{};
+    if (!key.empty() && deduplicator_->seen(key)) { return HttpResponse{200}; }
+
+    auto handler = event_handler_;
+    if (!submit([handler, payload] { handler(*payload); })) {
+        if (!key.empty()) { deduplicator_->erase(key); } // the retry must be accepted
+        return HttpResponse{503}; // Slack delivers the event again later
+    }
+    return HttpResponse{200};
+}
+
+inline
+void EventReceiver::queueResponse(Connection& connection, const HttpResponse& response, bool keep_alive) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << response.status << ' ' << http_reason(response.status) << "\r\n"
+        << "Content-Type: " << response.content_type << "\r\n"
+        << "Content-Length: " << response.body.size() << "\r\n"
+        << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n"
+        << response.body;
+    connection.out += out.str();
+    if (!keep_alive) { connection.close_after_write = true; }
+}
+
+} // namespace _detail
+
+using _detail::HttpRequest;
+using _detail::HttpResponse;
+using _detail::ReceiverOptions;
+using _detail::EventReceiver;
+
+} // namespace slack
+
+#endif // SLACKING_EVENT_RECEIVER_HPP_
@@ -0,0 +1,339 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: parallel export of conversations history to NDJSON files.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_HISTORY_EXPORT_HPP_
+#define SLACKING_HISTORY_EXPORT_HPP_
+
+#include "slacking.hpp"
+#include "methods.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <map>
+
+namespace slack {
+
+namespace _detail {
+
+struct ExportOptions {
+    std::string   directory{"."};           // where the NDJSON files are written
+    std::string   file_prefix{"export"};    // files are named <prefix>-000001.ndjson, <prefix>-000002.ndjson...
+    std::string   checkpoint_file{};        // empty: the export is not resumable
+    std::string   base_url{};               // empty: the default Slack Web API url
+    unsigned      workers{4};               // number of channels exported concurrently
+    std::uint64_t max_file_bytes{64u << 20};    // rotate the output file above this size
+    std::size_t   max_in_flight_bytes{8u << 20}; // bound of the messages waiting to be written
+    unsigned      page_limit{200};
+    bool          include_replies{true};    // also follow the threads with conversations.replies
+    std::string   oldest{};
+    std::string   latest{};
+    unsigned      max_retries{5};           // per page, when Slack answers 429 or fails (5xx)
+};
+
+struct ExportStats {
+    std::uint64_t messages{0};
+    std::uint64_t replies{0};
+    std::uint64_t pages{0};
+    std::uint64_t bytes{0};
+    std::vector<std::string> failed_channels{};
+};
+
+// Progress of every channel, saved after the messages of each page are written
+class ExportCheckpoint {
+public:
+    struct State {
+        std::string cursor{};
+        bool        done{false};
+
+        State() = default;
+        State(const std::string& c, bool d) : cursor{c}, done{d} {}
+    };
+
+    explicit ExportCheckpoint(const std::string& path) : path_{path} {
+        if (path_.empty()) { return; }
+        std::ifstream file(path_);
+        if (!file) { return; }
+        auto json = Json::parse(file, nullptr, false);
+        if (json.is_discarded()) { throw std::runtime_error("[slacking] corrupted checkpoint file " + path_); }
+        file_index_ = json.value("file_index", 0u);
+        for (auto it = json["channels"].begin(); it != json["channels"].end(); ++it) {
+            states_[it.key()] = State{it.value().value("cursor", ""), it.value().value("done", false)};
+        }
+    }
+
+    State state(const std::string& channel) const {
+        auto it = states_.find(channel);
+        return it == states_.end() ? State{} : it->second;
+    }
+
+    unsigned file_index() const { return file_index_; }
+
+    void update(const std::string& channel, const State& state, unsigned file_index) {
+        states_[channel] = state;
+        file_index_ = file_index;
+        save();
+    }
+
+private:
+    // written aside then renamed so that a crash never leaves a truncated checkpoint
+    void save() const {
+        if (path_.empty()) { return; }
+        Json json = {{"file_index", file_index_}, {"channels", Json::object()}};
+        for (auto const& state : states_) {
+            json["channels"][state.first] = {{"cursor", state.second.cursor}, {"done", state.second.done}};
+        }
+        auto tmp_path = path_ + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::trunc);
+            file << json.dump();
+            if (!file.flush()) { throw std::runtime_error("[slacking] cannot write checkpoint file " + tmp_path); }
+        }
+        if (!replace_file(tmp_path, path_)) {
+            throw std::runtime_error("[slacking] cannot rename checkpoint file " + tmp_path);
+        }
+    }
+
+    std::string path_;
+    unsigned    file_index_{0};
+    std::map<std::string, State> states_;
+};
+
+// NDJSON output which switches to a new file above a given size
+class NdjsonSink {
+public:
+    NdjsonSink(const std::string& directory, const std::string& prefix, std::uint64_t max_file_bytes, unsigned last_index)
+        : directory_{directory}, prefix_{prefix}, max_file_bytes_{max_file_bytes}, index_{last_index} {}
+
+    void write(const std::string& line) {
+        if (!file_.is_open() || written_ + line.size() + 1 > max_file_bytes_) { rotate(); }
+        file_ << line << '\n';
+        written_ += line.size() + 1;
+    }
+
+    void flush() {
+        if (file_.is_open() && !file_.flush()) { throw std::runtime_error("[slacking] cannot write " + current_path()); }
+    }
+
+    unsigned index() const { return index_; }
+
+private:
+    std::string current_path() const {
+        char number[16];
+        std::snprintf(number, sizeof(number), "%06u", index_);
+        return directory_ + '/' + prefix_ + '-' + number + ".ndjson";
+    }
+
+    // a resumed export never appends to a file of the previous run
+    void rotate() {
+        if (file_.is_open()) { flush(); file_.close(); }
+        ++index_;
+        file_.open(current_path(), std::ios::trunc);
+        if (!file_) { throw std::runtime_error("[slacking] cannot open " + current_path()); }
+        written_ = 0;
+    }
+
+    std::string   directory_;
+    std::string   prefix_;
+    std::uint64_t max_file_bytes_;
+    unsigned      index_;
+    std::uint64_t written_{0};
+    std::ofstream file_;
+};
+
+// Export conversations.history (and the thread replies) of many channels with a pool of workers.
+// Workers share one rate limiter so the export stays within the Slack tiers, and push the messages
+// to a bounded queue drained by a single writer thread: memory stays bounded whatever the history size.
+// The checkpoint is only advanced once the messages of a page are flushed, so a resumed export may
+// write again the messages of the page which was in progress, but never loses any.
+class HistoryExporter {
+public:
+    HistoryExporter(const std::string& token, ExportOptions options = ExportOptions{})
+        : token_{token}, options_(options), own_limiter_{new RateLimiter{}}, limiter_{own_limiter_.get()} {}
+
+    // Share a limiter with other components using the same token
+    void set_rate_limiter(RateLimiter& limiter) { limiter_ = &limiter; }
+
+    ExportStats run(const std::vector<std::string>& channel_ids);
+
+private:
+    struct Item {
+        std::string line{};
+        bool        is_checkpoint{false};
+        std::string channel{};
+        ExportCheckpoint::State state{};
+    };
+
+    void exportChannel(Slacking& slack, const std::string& channel, ExportCheckpoint::State state);
+    void exportReplies(Slacking& slack, const std::string& channel, const std::string& thread_ts);
+    Json call(Slacking& slack, const MethodDescriptor& method, const Json& arguments);
+    void pushMessage(const std::string& channel, Json& message);
+    void writeAll(ExportCheckpoint& checkpoint, NdjsonSink& sink);
+
+    std::string             token_;
+    ExportOptions           options_;
+    std::unique_ptr<RateLimiter> own_limiter_;
+    RateLimiter*            limiter_;
+    std::unique_ptr<BlockingQueue<Item>> queue_;
+    std::mutex              stats_mutex_;
+    ExportStats             stats_;
+    std::atomic<std::uint64_t> messages_{0};
+    std::atomic<std::uint64_t> replies_{0};
+    std::atomic<std::uint64_t> pages_{0};
+};
+
+inline
+ExportStats HistoryExporter::run(const std::vector<std::string>& channel_ids) {
+    ExportCheckpoint checkpoint{options_.checkpoint_file};
+    NdjsonSink sink{options_.directory, options_.file_prefix, options_.max_file_bytes, checkpoint.file_index()};
+    queue_.reset(new BlockingQueue<Item>{options_.max_in_flight_bytes});
+    stats_ = ExportStats{};
+    messages_ = replies_ = pages_ = 0;
+
+    std::exception_ptr writer_error;
+    std::thread writer([&] {
+        try { writeAll(checkpoint, sink); }
+        catch (...) { writer_error = std::current_exception(); queue_->close(); }
+    });
+
+    // the writer updates the checkpoint concurrently, workers start from a snapshot
+    std::vector<ExportCheckpoint::State> states;
+    for (auto const& channel : channel_ids) { states.push_back(checkpoint.state(channel)); }
+
+    std::atomic<std::size_t> next_channel{0};
+    auto work = [&] {
+        Slacking slack{token_};
+        if (!options_.base_url.empty()) { slack.setBaseUrl(options_.base_url); }
+        slack.set_rate_limiter(*limiter_);
+        for (auto i = next_channel++; i < channel_ids.size(); i = next_channel++) {
+            if (states[i].done) { continue; }
+            try { exportChannel(slack, channel_ids[i], states[i]); }
+            catch (std::exception& e) {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.failed_channels.push_back(channel_ids[i]);
+                std::cerr << "[slacking] export of " << channel_ids[i] << " failed. Reason: " << e.what() << '\n';
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < std::max(1u, options_.workers); ++w) { workers.emplace_back(work); }
+    for (auto& worker : workers) { worker.join(); }
+    queue_->close();
+    writer.join();
+    if (writer_error) { std::rethrow_exception(writer_error); }
+
+    stats_.messages = messages_;
+    stats_.replies  = replies_;
+    stats_.pages    = pages_;
+    return stats_;
+}
+
+inline
+void HistoryExporter::exportChannel(Slacking& slack, const std::string& channel, ExportCheckpoint::State state) {
+    do {
+        Json arguments = {{"channel", channel}, {"limit", options_.page_limit}};
+        if (!state.cursor.empty())   { arguments["cursor"] = state.cursor; }
+        if (!options_.oldest.empty()) { arguments["oldest"] = options_.oldest; }
+        if (!options_.latest.empty()) { arguments["latest"] = options_.latest; }
+
+        auto page = call(slack, methods::conversations_history, arguments);
+        for (auto& message : page["messages"]) {
+            pushMessage(channel, message);
+            ++messages_;
+            if (options_.include_replies && message.value("reply_count", 0) > 0
+                && message.value("thread_ts", "") == message.value("ts", "")) {
+                exportReplies(slack, channel, message.value("ts", ""));
+            }
+        }
+        ++pages_;
+
+        state.cursor = page.count("response_metadata") ? page["response_metadata"].value("next_cursor", "") : "";
+        state.done   = state.cursor.empty();
+        Item item;
+        item.is_checkpoint = true;
+        item.channel = channel;
+        item.state = state;
+        if (!queue_->push(std::move(item), 0)) { throw std::runtime_error("export aborted"); }
+    } while (!state.done);
+}
+
+inline
+void HistoryExporter::exportReplies(Slacking& slack, const std::string& channel, const std::string& thread_ts) {
+    std::string cursor{};
+    do {
+        Json arguments = {{"channel", channel}, {"ts", thread_ts}, {"limit", options_.page_limit}};
+        if (!cursor.empty()) { arguments["cursor"] = cursor; }
+        auto page = call(slack, methods::conversations_replies, arguments);
+        for (auto& message : page["messages"]) {
+            if (message.value("ts", "") == thread_ts) { continue; } // the parent is part of the history already
+            pushMessage(channel, message);
+            ++replies_;
+        }
+        cursor = page.count("response_metadata") ? page["response_metadata"].value("next_cursor", "") : "";
+    } while (!cursor.empty());
+}
+
+// A page without "ok": true (e.g. the HTML page of a 5xx, which gives no Json) is retried then thrown:
+// taken as an empty last page, it would checkpoint the channel as done
+inline
+Json HistoryExporter::call(Slacking& slack, const MethodDescriptor& method, const Json& arguments) {
+    for (unsigned attempt = 0; ; ++attempt) {
+        Json page;
+        try {
+            page = slack.call(method, arguments); // paced at the tier of the method, held after a 429
+        }
+        catch (RateLimited&) {
+            if (attempt >= options_.max_retries) { throw; }
+            continue;
+        }
+        if (page.is_object() && page.value("ok", false)) { return page; }
+        if (attempt >= options_.max_retries) {
+            auto reason = page.is_object() ? page.value("error", "not ok") : std::string{"no Json answer"};
+            throw std::runtime_error("[slacking] " + std::string{method.name} + " failed: " + reason);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{250} * (1 << std::min(attempt, 6u)));
+    }
+}
+
+inline
+void HistoryExporter::pushMessage(const std::string& channel, Json& message) {
+    message["channel"] = channel;
+    Item item;
+    item.line = message.dump();
+    auto cost = item.line.size();
+    if (!queue_->push(std::move(item), cost)) { throw std::runtime_error("export aborted"); }
+}
+
+inline
+void HistoryExporter::writeAll(ExportCheckpoint& checkpoint, NdjsonSink& sink) {
+    Item item;
+    std::uint64_t bytes = 0;
+    while (queue_->pop(item)) {
+        if (item.is_checkpoint) {
+            sink.flush();
+            checkpoint.update(item.channel, item.state, sink.index());
+        }
+        else {
+            sink.write(item.line);
+            bytes += item.line.size() + 1;
+        }
+    }
+    sink.flush();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.bytes = bytes;
+}
+
+} // namespace _detail
+
+using _detail::ExportOptions;
+using _detail::ExportStats;
+using _detail::HistoryExporter;
+
+} // namespace slack
+
+#endif // SLACKING_HISTORY_EXPORT_HPP_
@@ -0,0 +1,315 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: slash commands and interactive components.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_INTERACTIVITY_HPP_
+#define SLACKING_INTERACTIVITY_HPP_
+
+#include "slacking.hpp"
+#include "methods.hpp"
+
+#if defined(__linux__)
+# include "event_receiver.hpp"
+#endif
+
+#include <map>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+struct SlashCommand {
+    std::string command;
+    std::string text;
+    std::string user_id;
+    std::string user_name;
+    std::string channel_id;
+    std::string team_id;
+    std::string response_url;
+    std::string trigger_id;
+};
+
+// block_actions, view_submission, shortcut... the full payload is kept in payload
+struct Interaction {
+    std::string type;
+    std::string user_id;
+    std::string channel_id;
+    std::string response_url;
+    std::string trigger_id;
+    std::string view_id;
+    std::string action_id;   // first action of block_actions
+    std::string callback_id; // of the view or of the shortcut
+    Json        payload;
+};
+
+// Dedicated lane for the answers to commands and interactions: its own thread, queue and connections
+// (kept alive to hooks.slack.com and slack.com), so an answer never waits behind bulk Web API traffic.
+class ResponseLane {
+public:
+    // token is a bot token, only needed by update_view()
+    explicit ResponseLane(const std::string& token = "", std::size_t capacity = 256)
+        : slack_{token}, hooks_{false}, queue_{capacity} {
+        hooks_.SetContentType("application/json");
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~ResponseLane() { stop(); }
+
+    ResponseLane(const ResponseLane&)            = delete;
+    ResponseLane& operator=(const ResponseLane&) = delete;
+
+    void setBaseUrl(const std::string& url) { slack_.setBaseUrl(url); }
+
+    // Post a message to a response_url: {"text": ..., "response_type": "in_channel", "replace_original": true}
+    void respond(const std::string& response_url, const Json& message) {
+        queue_.push(Job{response_url, message.dump()});
+    }
+
+    // views.update with {"view_id": ..., "view": {...}}, optionally "hash"
+    void update_view(const Json& arguments) {
+        queue_.push(Job{"", arguments.dump()});
+    }
+
+    // Send the queued answers then join the thread
+    void stop() {
+        queue_.close();
+        if (thread_.joinable()) { thread_.join(); }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::string response_url; // empty for views.update
+        std::string body;
+        unsigned    attempts{0};
+
+        Job() = default;
+        Job(const std::string& url, const std::string& b) : response_url{url}, body{b} {}
+    };
+
+    // A job to retry waits aside until it is due, so that the answers queued meanwhile are not held behind it
+    void run() {
+        std::multimap<Clock::time_point, Job> deferred;
+        for (;;) {
+            Job job;
+            if (!deferred.empty() && Clock::now() >= deferred.begin()->first) {
+                job = std::move(deferred.begin()->second);
+                deferred.erase(deferred.begin());
+            }
+            else if (!(deferred.empty() ? queue_.pop(job) : queue_.pop_until(job, deferred.begin()->first))) {
+                if (deferred.empty()) { break; } // stopped, everything sent
+                if (queue_.closed()) { std::this_thread::sleep_until(deferred.begin()->first); }
+                continue;
+            }
+            auto delay = attempt(job);
+            if (delay.count() >= 0 && ++job.attempts < max_attempts) { deferred.emplace(Clock::now() + delay, std::move(job)); }
+        }
+    }
+
+    // Delay before trying the job again, negative once it is done with
+    std::chrono::milliseconds attempt(const Job& job) {
+        try {
+            return send(job) ? std::chrono::milliseconds{-1} : std::chrono::milliseconds{500}; // 5xx: short backoff
+        }
+        catch (RateLimited& e) {
+            return std::chrono::seconds{std::max(1l, e.retry_after())};
+        }
+        catch (std::exception& e) {
+            std::cerr << "[slacking] response failed. Reason: " << e.what() << '\n';
+            return std::chrono::milliseconds{500};
+        }
+    }
+
+    // false if worth retrying
+    bool send(const Job& job) {
+        if (job.response_url.empty()) {
+            slack_.call(methods::views_update, Json::parse(job.body)); // a JSON body: the view is sent as is
+            return true;
+        }
+        hooks_.SetUrl(job.response_url);
+        hooks_.SetBody(job.body);
+        auto response = hooks_.Post();
+        if (response.is_error || response.status_code >= 500) { return false; }
+        if (response.status_code != 200) {
+            std::cerr << "[slacking] response_url answered " << response.status_code << ": " << response.text << '\n';
+        }
+        return true;
+    }
+
+    static const unsigned    max_attempts = 2;
+
+    Slacking                 slack_;
+    Session                  hooks_;
+    BlockingQueue<Job>       queue_;
+    std::thread              thread_;
+};
+
+// Given to the handlers to answer the command or the interaction they are running for
+class Responder {
+public:
+    Responder(ResponseLane& lane, const std::string& response_url, const std::string& view_id)
+        : lane_(lane), response_url_{response_url}, view_id_{view_id} {}
+
+    // Ephemeral message by default, {"response_type": "in_channel"} to show it to everyone
+    void respond(const Json& message) const {
+        if (response_url_.empty()) { throw std::runtime_error("[slacking] no response_url to answer to"); }
+        lane_.respond(response_url_, message);
+    }
+
+    void respond(const std::string& text) const { respond(Json{{"text", text}}); }
+
+    // Update the modal the interaction comes from
+    void update_view(const Json& view) const {
+        if (view_id_.empty()) { throw std::runtime_error("[slacking] no view to update"); }
+        lane_.update_view(Json{{"view_id", view_id_}, {"view", view}});
+    }
+
+private:
+    ResponseLane& lane_;
+    std::string   response_url_;
+    std::string   view_id_;
+};
+
+// Run slash commands and interaction handlers outside of the 3 seconds ack window: the request is acknowledged
+// at once with an empty 200, the handler runs on a worker pool and answers later through the response lane.
+class Interactivity {
+public:
+    using CommandHandler     = std::function<void(const SlashCommand& command, const Responder& responder)>;
+    using InteractionHandler = std::function<void(const Interaction& interaction, const Responder& responder)>;
+
+    explicit Interactivity(ResponseLane& lane) : lane_(lane) {}
+
+    // Set the handlers before receiving
+    void on_command(const std::string& command, CommandHandler handler) { commands_[command] = handler; }
+    void on_action(const std::string& action_id, InteractionHandler handler) { actions_[action_id] = handler; }
+    void on_view(const std::string& callback_id, InteractionHandler handler) { views_[callback_id] = handler; }
+    void on_interaction(InteractionHandler handler) { fallback_ = handler; } // anything else
+
+    // The task running the handler, empty if there is no handler
+    std::function<void()> command_task(const std::map<std::string, std::string>& form) const;
+    std::function<void()> interaction_task(const Json& payload) const;
+
+    // Socket Mode: call it from SocketModeClient::on_envelope, which has already acknowledged the envelope
+    void handle_envelope(const std::string& type, const Json& envelope) const {
+        std::function<void()> task;
+        if (type == "slash_commands") {
+            std::map<std::string, std::string> form;
+            auto const& payload = envelope["payload"];
+            for (auto it = payload.begin(); it != payload.end(); ++it) {
+                if (it.value().is_string()) { form[it.key()] = it.value().get<std::string>(); }
+            }
+            task = command_task(form);
+        }
+        else if (type == "interactive") {
+            task = interaction_task(envelope["payload"]);
+        }
+        if (task) { task(); }
+    }
+
+#if defined(__linux__)
+    // Serve the Request URLs of the slash commands and of the interactivity on an EventReceiver
+    void attach(EventReceiver& receiver, const std::string& commands_path = "/slack/commands",
+                const std::string& interactivity_path = "/slack/interactivity") const {
+        auto enqueue = [&receiver](std::function<void()> task) {
+            if (!task) { return HttpResponse{404}; }
+            return receiver.submit(std::move(task)) ? HttpResponse{200} : HttpResponse{503};
+        };
+        receiver.route(commands_path, [this, enqueue](const HttpRequest& request) {
+            return enqueue(command_task(parse_form(request.body)));
+        });
+        receiver.route(interactivity_path, [this, enqueue](const HttpRequest& request) {
+            auto form = parse_form(request.body);
+            auto payload = Json::parse(form["payload"], nullptr, false);
+            if (payload.is_discarded() || !payload.is_object()) { return HttpResponse{400}; }
+            return enqueue(interaction_task(payload));
+        });
+    }
+#endif
+
+private:
+    static std::string string_at(const Json& json, const char* key, const char* nested = nullptr) {
+        auto it = json.find(key);
+        if (it == json.end()) { return ""; }
+        if (nested) { return it->is_object() ? it->value(nested, "") : ""; }
+        return it->is_string() ? it->get<std::string>() : "";
+    }
+
+    ResponseLane&                             lane_;
+    std::map<std::string, CommandHandler>     commands_;
+    std::map<std::string, InteractionHandler> actions_;
+    std::map<std::string, InteractionHandler> views_;
+    InteractionHandler                        fallback_;
+};
+
+inline
+std::function<void()> Interactivity::command_task(const std::map<std::string, std::string>& form) const {
+    auto value = [&form](const char* key) {
+        auto it = form.find(key);
+        return it == form.end() ? std::string{} : it->second;
+    };
+    auto handler = commands_.find(value("command"));
+    if (handler == commands_.end()) { return {}; }
+
+    auto command = std::make_shared<SlashCommand>();
+    command->command      = value("command");
+    command->text         = value("text");
+    command->user_id      = value("user_id");
+    command->user_name    = value("user_name");
+    command->channel_id   = value("channel_id");
+    command->team_id      = value("team_id");
+    command->response_url = value("response_url");
+    command->trigger_id   = value("trigger_id");
+    auto& lane = lane_;
+    auto run = handler->second;
+    return [&lane, run, command] { run(*command, Responder{lane, command->response_url, ""}); };
+}
+
+inline
+std::function<void()> Interactivity::interaction_task(const Json& payload) const {
+    auto interaction = std::make_shared<Interaction>();
+    interaction->type         = string_at(payload, "type");
+    interaction->user_id      = string_at(payload, "user", "id");
+    interaction->channel_id   = string_at(payload, "channel", "id");
+    interaction->response_url = string_at(payload, "response_url");
+    interaction->trigger_id   = string_at(payload, "trigger_id");
+    interaction->view_id      = string_at(payload, "view", "id");
+    interaction->callback_id  = payload.count("view") ? string_at(payload, "view", "callback_id") : string_at(payload, "callback_id");
+    auto actions = payload.find("actions");
+    if (actions != payload.end() && actions->is_array() && !actions->empty()) {
+        interaction->action_id = string_at(actions->front(), "action_id");
+    }
+    if (interaction->response_url.empty()) { // view_submission
+        auto urls = payload.find("response_urls");
+        if (urls != payload.end() && urls->is_array() && !urls->empty()) {
+            interaction->response_url = string_at(urls->front(), "response_url");
+        }
+    }
+    interaction->payload = payload;
+
+    InteractionHandler run;
+    auto action = actions_.find(interaction->action_id);
+    auto view   = views_.find(interaction->callback_id);
+    if (!interaction->action_id.empty() && action != actions_.end())      { run = action->second; }
+    else if (!interaction->callback_id.empty() && view != views_.end())   { run = view->second; }
+    else if (fallback_)                                                   { run = fallback_; }
+    else { return {}; }
+
+    auto& lane = lane_;
+    return [&lane, run, interaction] { run(*interaction, Responder{lane, interaction->response_url, interaction->view_id}); };
+}
+
+} // namespace _detail
+
+using _detail::SlashCommand;
+using _detail::Interaction;
+using _detail::ResponseLane;
+using _detail::Responder;
+using _detail::Interactivity;
+
+} // namespace slack
+
+#endif // SLACKING_INTERACTIVITY_HPP_
@@ -0,0 +1,161 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: catalog of the Web API methods as compile time descriptors, to use with Slacking::call().
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_METHODS_HPP_
+#define SLACKING_METHODS_HPP_
+
+#include "slacking.hpp"
+
+// The catalog: X(identifier, name, verb, rate tier, encoding, required arguments...). Verbs, tiers and
+// arguments follow https://api.slack.com/methods. Methods taking blocks or a view are sent as Json.
+// Every entry ends with a comma, even without required argument: C++11 variadic macros need an argument.
+#define SLACKING_WEB_API_METHODS(X) \
+    X(api_test,                        "api.test",                        Get,  Tier4,   Form, ) \
+    X(apps_connections_open,           "apps.connections.open",           Post, Tier1,   Form, ) \
+    X(apps_event_authorizations_list,  "apps.event.authorizations.list",  Post, Tier4,   Form, "event_context") \
+    X(apps_uninstall,                  "apps.uninstall",                  Get,  Tier1,   Form, "client_id", "client_secret") \
+    X(auth_revoke,                     "auth.revoke",                     Get,  Tier3,   Form, ) \
+    X(auth_teams_list,                 "auth.teams.list",                 Get,  Tier2,   Form, ) \
+    X(auth_test,                       "auth.test",                       Post, Tier4,   Form, ) \
+    X(bookmarks_add,                   "bookmarks.add",                   Post, Tier2,   Form, "channel_id", "title", "type") \
+    X(bookmarks_edit,                  "bookmarks.edit",                  Post, Tier2,   Form, "bookmark_id", "channel_id") \
+    X(bookmarks_list,                  "bookmarks.list",                  Post, Tier3,   Form, "channel_id") \
+    X(bookmarks_remove,                "bookmarks.remove",                Post, Tier2,   Form, "bookmark_id", "channel_id") \
+    X(bots_info,                       "bots.info",                       Get,  Tier3,   Form, ) \
+    X(chat_delete,                     "chat.delete",                     Post, Tier3,   Form, "channel", "ts") \
+    X(chat_deleteScheduledMessage,     "chat.deleteScheduledMessage",     Post, Tier3,   Form, "channel", "scheduled_message_id") \
+    X(chat_getPermalink,               "chat.getPermalink",               Get,  Tier4,   Form, "channel", "message_ts") \
+    X(chat_meMessage,                  "chat.meMessage",                  Post, Tier3,   Form, "channel", "text") \
+    X(chat_postEphemeral,              "chat.postEphemeral",              Post, Tier4,   Json, "channel", "user") \
+    X(chat_postMessage,                "chat.postMessage",                Post, Special, Json, "channel") \
+    X(chat_scheduleMessage,            "chat.scheduleMessage",            Post, Tier3,   Json, "channel", "post_at") \
+    X(chat_scheduledMessages_list,     "chat.scheduledMessages.list",     Post, Tier3,   Form, ) \
+    X(chat_unfurl,                     "chat.unfurl",                     Post, Tier3,   Json, "channel", "ts", "unfurls") \
+    X(chat_update,                     "chat.update",                     Post, Tier3,   Json, "channel", "ts") \
+    X(conversations_archive,           "conversations.archive",           Post, Tier2,   Form, "channel") \
+    X(conversations_close,             "conversations.close",             Post, Tier2,   Form, "channel") \
+    X(conversations_create,            "conversations.create",            Post, Tier2,   Form, "name") \
+    X(conversations_history,           "conversations.history",           Get,  Tier3,   Form, "channel") \
+    X(conversations_info,              "conversations.info",              Get,  Tier3,   Form, "channel") \
+    X(conversations_invite,            "conversations.invite",            Post, Tier3,   Form, "channel", "users") \
+    X(conversations_join,              "conversations.join",              Post, Tier3,   Form, "channel") \
+    X(conversations_kick,              "conversations.kick",              Post, Tier3,   Form, "channel", "user") \
+    X(conversations_leave,             "conversations.leave",             Post, Tier3,   Form, "channel") \
+    X(conversations_list,              "conversations.list",              Get,  Tier2,   Form, ) \
+    X(conversations_mark,              "conversations.mark",              Post, Tier3,   Form, "channel", "ts") \
+    X(conversations_members,           "conversations.members",           Get,  Tier4,   Form, "channel") \
+    X(conversations_open,              "conversations.open",              Post, Tier3,   Form, ) \
+    X(conversations_rename,            "conversations.rename",            Post, Tier2,   Form, "channel", "name") \
+    X(conversations_replies,           "conversations.replies",           Get,  Tier3,   Form, "channel", "ts") \
+    X(conversations_setPurpose,        "conversations.setPurpose",        Post, Tier2,   Form, "channel", "purpose") \
+    X(conversations_setTopic,          "conversations.setTopic",          Post, Tier2,   Form, "channel", "topic") \
+    X(conversations_unarchive,         "conversations.unarchive",         Post, Tier2,   Form, "channel") \
+    X(dialog_open,                     "dialog.open",                     Post, Tier4,   Json, "dialog", "trigger_id") \
+    X(dnd_endDnd,                      "dnd.endDnd",                      Post, Tier2,   Form, ) \
+    X(dnd_endSnooze,                   "dnd.endSnooze",                   Post, Tier2,   Form, ) \
+    X(dnd_info,                        "dnd.info",                        Get,  Tier3,   Form, ) \
+    X(dnd_setSnooze,                   "dnd.setSnooze",                   Post, Tier2,   Form, "num_minutes") \
+    X(dnd_teamInfo,                    "dnd.teamInfo",                    Get,  Tier2,   Form, ) \
+    X(emoji_list,                      "emoji.list",                      Get,  Tier2,   Form, ) \
+    X(files_completeUploadExternal,    "files.completeUploadExternal",    Post, Tier4,   Form, "files") \
+    X(files_delete,                    "files.delete",                    Post, Tier3,   Form, "file") \
+    X(files_getUploadURLExternal,      "files.getUploadURLExternal",      Get,  Tier4,   Form, "filename", "length") \
+    X(files_info,                      "files.info",                      Get,  Tier4,   Form, "file") \
+    X(files_list,                      "files.list",                      Get,  Tier3,   Form, ) \
+    X(files_remote_add,                "files.remote.add",                Post, Tier2,   Form, "external_id", "external_url", "title") \
+    X(files_remote_info,               "files.remote.info",               Get,  Tier2,   Form, ) \
+    X(files_remote_list,               "files.remote.list",               Get,  Tier2,   Form, ) \
+    X(files_remote_remove,             "files.remote.remove",             Post, Tier2,   Form, ) \
+    X(files_remote_share,              "files.remote.share",              Get,  Tier2,   Form, "channels") \
+    X(files_remote_update,             "files.remote.update",             Post, Tier2,   Form, ) \
+    X(files_revokePublicURL,           "files.revokePublicURL",           Post, Tier3,   Form, "file") \
+    X(files_sharedPublicURL,           "files.sharedPublicURL",           Post, Tier3,   Form, "file") \
+    X(pins_add,                        "pins.add",                        Post, Tier2,   Form, "channel") \
+    X(pins_list,                       "pins.list",                       Get,  Tier2,   Form, "channel") \
+    X(pins_remove,                     "pins.remove",                     Post, Tier2,   Form, "channel") \
+    X(reactions_add,                   "reactions.add",                   Post, Tier3,   Form, "channel", "name", "timestamp") \
+    X(reactions_get,                   "reactions.get",                   Get,  Tier3,   Form, ) \
+    X(reactions_list,                  "reactions.list",                  Get,  Tier2,   Form, ) \
+    X(reactions_remove,                "reactions.remove",                Post, Tier2,   Form, "name") \
+    X(reminders_add,                   "reminders.add",                   Post, Tier2,   Form, "text", "time") \
+    X(reminders_complete,              "reminders.complete",              Post, Tier2,   Form, "reminder") \
+    X(reminders_delete,                "reminders.delete",                Post, Tier2,   Form, "reminder") \
+    X(reminders_info,                  "reminders.info",                  Get,  Tier2,   Form, "reminder") \
+    X(reminders_list,                  "reminders.list",                  Get,  Tier2,   Form, ) \
+    X(search_all,                      "search.all",                      Get,  Tier2,   Form, "query") \
+    X(search_files,                    "search.files",                    Get,  Tier2,   Form, "query") \
+    X(search_messages,                 "search.messages",                 Get,  Tier2,   Form, "query") \
+    X(team_accessLogs,                 "team.accessLogs",                 Get,  Tier2,   Form, ) \
+    X(team_billableInfo,               "team.billableInfo",               Get,  Tier2,   Form, ) \
+    X(team_info,                       "team.info",                       Get,  Tier3,   Form, ) \
+    X(team_integrationLogs,            "team.integrationLogs",            Get,  Tier2,   Form, ) \
+    X(team_profile_get,                "team.profile.get",                Get,  Tier3,   Form, ) \
+    X(usergroups_create,               "usergroups.create",               Post, Tier2,   Form, "name") \
+    X(usergroups_disable,              "usergroups.disable",              Post, Tier2,   Form, "usergroup") \
+    X(usergroups_enable,               "usergroups.enable",               Post, Tier2,   Form, "usergroup") \
+    X(usergroups_list,                 "usergroups.list",                 Get,  Tier2,   Form, ) \
+    X(usergroups_update,               "usergroups.update",               Post, Tier2,   Form, "usergroup") \
+    X(usergroups_users_list,           "usergroups.users.list",           Get,  Tier2,   Form, "usergroup") \
+    X(usergroups_users_update,         "usergroups.users.update",         Post, Tier2,   Form, "usergroup", "users") \
+    X(users_conversations,             "users.conversations",             Get,  Tier3,   Form, ) \
+    X(users_deletePhoto,               "users.deletePhoto",               Post, Tier2,   Form, ) \
+    X(users_getPresence,               "users.getPresence",               Get,  Tier3,   Form, "user") \
+    X(users_identity,                  "users.identity",                  Get,  Tier4,   Form, ) \
+    X(users_info,                      "users.info",                      Get,  Tier4,   Form, "user") \
+    X(users_list,                      "users.list",                      Get,  Tier2,   Form, ) \
+    X(users_lookupByEmail,             "users.lookupByEmail",             Get,  Tier3,   Form, "email") \
+    X(users_profile_get,               "users.profile.get",               Get,  Tier4,   Form, ) \
+    X(users_profile_set,               "users.profile.set",               Post, Tier3,   Json, ) \
+    X(users_setPresence,               "users.setPresence",               Post, Tier2,   Form, "presence") \
+    X(views_open,                      "views.open",                      Post, Tier4,   Json, "trigger_id", "view") \
+    X(views_publish,                   "views.publish",                   Post, Tier4,   Json, "user_id", "view") \
+    X(views_push,                      "views.push",                      Post, Tier4,   Json, "trigger_id", "view") \
+    X(views_update,                    "views.update",                    Post, Tier4,   Json, "view")
+
+namespace slack {
+
+namespace methods {
+
+// Position of each method in the catalog
+enum class Index : std::size_t {
+#define SLACKING_METHOD_INDEX(identifier, name, verb, tier, encoding, ...) identifier,
+    SLACKING_WEB_API_METHODS(SLACKING_METHOD_INDEX)
+#undef SLACKING_METHOD_INDEX
+};
+
+#define SLACKING_METHOD_COUNT(identifier, name, verb, tier, encoding, ...) + 1
+constexpr std::size_t count = 0 SLACKING_WEB_API_METHODS(SLACKING_METHOD_COUNT);
+#undef SLACKING_METHOD_COUNT
+
+// One descriptor per method, e.g. slack::methods::chat_postMessage. The leading nullptr of the required
+// arguments keeps the array valid for methods without any.
+#define SLACKING_METHOD_DESCRIPTOR(identifier, name, verb, tier, encoding, ...)                                   \
+    constexpr const char* identifier##_required[] = {nullptr, __VA_ARGS__};                                      \
+    constexpr MethodDescriptor identifier{static_cast<std::size_t>(Index::identifier), name, HttpVerb::verb,     \
+        RateTier::tier, ArgumentEncoding::encoding, identifier##_required + 1,                                   \
+        sizeof(identifier##_required) / sizeof(identifier##_required[0]) - 1};
+SLACKING_WEB_API_METHODS(SLACKING_METHOD_DESCRIPTOR)
+#undef SLACKING_METHOD_DESCRIPTOR
+
+// Every descriptor, in the order of the catalog: e.g. to configure a rate limiter or pre-register metrics
+#define SLACKING_METHOD_ADDRESS(identifier, name, verb, tier, encoding, ...) &identifier,
+constexpr const MethodDescriptor* all[] = { SLACKING_WEB_API_METHODS(SLACKING_METHOD_ADDRESS) };
+#undef SLACKING_METHOD_ADDRESS
+
+// Descriptor of a method given by name, nullptr if it is not in the catalog
+inline
+const MethodDescriptor* find(const std::string& name) {
+    for (auto method : all) {
+        if (name == method->name) { return method; }
+    }
+    return nullptr;
+}
+
+} // namespace methods
+
+} // namespace slack
+
+#endif // SLACKING_METHODS_HPP_
@@ -0,0 +1,223 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: metrics of the Web API calls in the Prometheus text format.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_METRICS_HPP_
+#define SLACKING_METRICS_HPP_
+
+#include "slacking.hpp"
+
+#if defined(__linux__)
+# include "event_receiver.hpp"
+#endif
+
+#include <atomic>
+#include <map>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+// Per method request, error and 429 counts, in-flight gauge and latency histogram of the calls of the Slacking
+// instances it observes (Slacking::set_observer()), rendered in the Prometheus text exposition format.
+// Recording is lock free: methods are found in a fixed open addressing table filled with compare-and-swap, and
+// every counter is sharded per thread on its own cache line. Only the Slack error codes, which are rare and
+// unbounded, are counted under a mutex. One Metrics can observe many Slacking instances.
+class Metrics : public CallObserver {
+public:
+    static constexpr std::size_t kShards  = 16;
+    static constexpr std::size_t kBuckets = 12; // upper bounds of latency_bounds() then +Inf
+    static constexpr std::size_t kMethods = 512;
+
+    Metrics() {
+        for (auto& slot : table_) { slot.store(nullptr, std::memory_order_relaxed); }
+    }
+
+    ~Metrics() {
+        for (auto& slot : table_) { delete slot.load(std::memory_order_relaxed); }
+    }
+
+    Metrics(const Metrics&)            = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void started(const std::string& method) override {
+        lookup(method).shards[shard()].in_flight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finished(const std::string& method, std::chrono::steady_clock::duration latency, long status_code, const std::string& error) override {
+        auto& shard_counters = lookup(method).shards[shard()];
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        std::size_t bucket = 0;
+        while (bucket < kBuckets - 1 && micros > latency_bounds()[bucket]) { ++bucket; }
+
+        shard_counters.in_flight.fetch_sub(1, std::memory_order_relaxed);
+        shard_counters.requests.fetch_add(1, std::memory_order_relaxed);
+        shard_counters.latency_micros.fetch_add(static_cast<std::uint64_t>(micros), std::memory_order_relaxed);
+        shard_counters.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        // an answer other than 2xx is an error even when the observer reporting it did not name one
+        auto code = error;
+        if (code.empty() && status_code == 429) { code = "ratelimited"; }
+        else if (code.empty() && status_code != 0 && (status_code < 200 || status_code >= 300)) { code = "http_" + std::to_string(status_code); }
+        if (code.empty()) { return; }
+        shard_counters.errors.fetch_add(1, std::memory_order_relaxed);
+        if (code == "ratelimited") { shard_counters.ratelimited.fetch_add(1, std::memory_order_relaxed); }
+
+        std::lock_guard<std::mutex> lock(errors_mutex_);
+        ++error_codes_[std::make_pair(method, code)];
+    }
+
+    // Upper bounds of the latency buckets, in microseconds
+    static const long long* latency_bounds() {
+        static const long long bounds[kBuckets - 1] = {5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+        return bounds;
+    }
+
+    // Prometheus text exposition format (version 0.0.4)
+    std::string render() const;
+
+private:
+    // new does not honour alignas before C++17: the padding keeps the counters of two shards off the same cache line
+    struct Shard {
+        char                       padding[64];
+        std::atomic<std::int64_t>  in_flight{0};
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::atomic<std::uint64_t> ratelimited{0};
+        std::atomic<std::uint64_t> latency_micros{0};
+        std::atomic<std::uint64_t> buckets[kBuckets];
+
+        Shard() { for (auto& bucket : buckets) { bucket.store(0, std::memory_order_relaxed); } }
+    };
+
+    struct MethodMetrics {
+        std::string method;
+        Shard       shards[kShards];
+
+        explicit MethodMetrics(const std::string& m) : method{m} {}
+    };
+
+    // threads are spread over the shards in the order they first record something
+    static std::size_t shard() {
+        static std::atomic<std::size_t> next{0};
+        static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return index;
+    }
+
+    MethodMetrics& lookup(const std::string& method) {
+        auto start = std::hash<std::string>{}(method) % kMethods;
+        for (std::size_t probe = 0; probe < kMethods; ++probe) {
+            auto& slot = table_[(start + probe) % kMethods];
+            auto existing = slot.load(std::memory_order_acquire);
+            if (!existing) {
+                std::unique_ptr<MethodMetrics> created{new MethodMetrics{method}};
+                if (slot.compare_exchange_strong(existing, created.get(), std::memory_order_acq_rel)) { return *created.release(); }
+                // another thread filled the slot first, existing is now its entry
+            }
+            if (existing->method == method) { return *existing; }
+        }
+        return overflow_; // more distinct methods than slots
+    }
+
+    static std::string escape(const std::string& value) {
+        std::string out;
+        for (char c : value) {
+            if (c == '\\' || c == '"') { out += '\\'; out += c; }
+            else if (c == '\n') { out += "\\n"; }
+            else { out += c; }
+        }
+        return out;
+    }
+
+    std::atomic<MethodMetrics*> table_[kMethods];
+    MethodMetrics               overflow_{"other"};
+    mutable std::mutex          errors_mutex_;
+    std::map<std::pair<std::string, std::string>, std::uint64_t> error_codes_;
+};
+
+inline
+std::string Metrics::render() const {
+    struct Totals {
+        std::string   method;
+        std::int64_t  in_flight{0};
+        std::uint64_t requests{0}, errors{0}, ratelimited{0}, latency_micros{0};
+        std::uint64_t buckets[kBuckets] = {};
+    };
+    std::vector<Totals> methods;
+    auto add = [&methods](const MethodMetrics& entry) {
+        Totals totals;
+        totals.method = entry.method;
+        for (auto const& shard : entry.shards) {
+            totals.in_flight      += shard.in_flight.load(std::memory_order_relaxed);
+            totals.requests       += shard.requests.load(std::memory_order_relaxed);
+            totals.errors         += shard.errors.load(std::memory_order_relaxed);
+            totals.ratelimited    += shard.ratelimited.load(std::memory_order_relaxed);
+            totals.latency_micros += shard.latency_micros.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < kBuckets; ++i) { totals.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed); }
+        }
+        if (totals.requests > 0 || totals.in_flight > 0) { methods.push_back(totals); }
+    };
+    for (auto const& slot : table_) {
+        if (auto entry = slot.load(std::memory_order_acquire)) { add(*entry); }
+    }
+    add(overflow_);
+    std::sort(methods.begin(), methods.end(), [](const Totals& a, const Totals& b) { return a.method < b.method; });
+
+    std::ostringstream out;
+    auto family = [&out](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+    family("slacking_requests_total", "counter", "Web API calls by method.");
+    for (auto const& m : methods) { out << "slacking_requests_total{method=\"" << escape(m.method) << "\"} " << m.requests << '\n'; }
+    family("slacking_errors_total", "counter", "Web API calls which failed, by method.");
+    for (auto const& m : methods) { out << "slacking_errors_total{method=\"" << escape(m.method) << "\"} " << m.errors << '\n'; }
+    family("slacking_ratelimited_total", "counter", "Web API calls answered with HTTP 429, by method.");
+    for (auto const& m : methods) { out << "slacking_ratelimited_total{method=\"" << escape(m.method) << "\"} " << m.ratelimited << '\n'; }
+    family("slacking_in_flight", "gauge", "Web API calls in progress, by method.");
+    for (auto const& m : methods) { out << "slacking_in_flight{method=\"" << escape(m.method) << "\"} " << m.in_flight << '\n'; }
+
+    family("slacking_error_codes_total", "counter", "Web API calls which failed, by method and error code.");
+    {
+        std::lock_guard<std::mutex> lock(errors_mutex_);
+        for (auto const& error : error_codes_) {
+            out << "slacking_error_codes_total{method=\"" << escape(error.first.first) << "\",error=\"" << escape(error.first.second) << "\"} " << error.second << '\n';
+        }
+    }
+
+    family("slacking_request_duration_seconds", "histogram", "Latency of the Web API calls, by method.");
+    for (auto const& m : methods) {
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            cumulative += m.buckets[i];
+            out << "slacking_request_duration_seconds_bucket{method=\"" << escape(m.method) << "\",le=\"";
+            if (i < kBuckets - 1) { out << latency_bounds()[i] / 1e6; } else { out << "+Inf"; }
+            out << "\"} " << cumulative << '\n';
+        }
+        out << "slacking_request_duration_seconds_sum{method=\"" << escape(m.method) << "\"} " << m.latency_micros / 1e6 << '\n';
+        out << "slacking_request_duration_seconds_count{method=\"" << escape(m.method) << "\"} " << m.requests << '\n';
+    }
+    return out.str();
+}
+
+#if defined(__linux__)
+// Serve the metrics on an EventReceiver, e.g. for a Prometheus scraper
+inline
+void serve_metrics(EventReceiver& receiver, std::shared_ptr<const Metrics> metrics, const std::string& path = "/metrics") {
+    receiver.route(path, [metrics](const HttpRequest&) {
+        return HttpResponse{200, "text/plain; version=0.0.4", metrics->render()};
+    }, false);
+}
+#endif
+
+} // namespace _detail
+
+using _detail::Metrics;
+#if defined(__linux__)
+using _detail::serve_metrics;
+#endif
+
+} // namespace slack
+
+#endif // SLACKING_METRICS_HPP_
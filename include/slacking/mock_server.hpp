@@ -0,0 +1,1096 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: in-process mock of the Web API and of the incoming webhooks, with fault injection (POSIX only, zlib).
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_MOCK_SERVER_HPP_
+#define SLACKING_MOCK_SERVER_HPP_
+
+#include "slacking.hpp"
+#include "compression.hpp"
+
+#if defined(_WIN32)
+# error "mock_server.hpp relies on POSIX sockets"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if !defined(MSG_NOSIGNAL) // macOS: SO_NOSIGPIPE is set on the sockets instead
+# define MSG_NOSIGNAL 0
+#endif
+
+namespace slack {
+
+namespace _detail {
+
+struct MockOptions {
+    std::string    address{"127.0.0.1"};
+    unsigned short port{0};          // 0: any free port, see MockSlack::port()
+    std::string    token{};          // when set, the calls with another token fail with invalid_auth
+    std::size_t    users{50};        // members of users.list
+    std::size_t    channels{20};     // channels of conversations.list
+    std::size_t    messages{100};    // messages of conversations.history, per channel
+    std::size_t    page_size{100};   // default limit of the paginated methods
+};
+
+// What to do to a request instead of (or before) answering it normally. The fields combine:
+// e.g. latency and status answer an error after a delay.
+struct MockFault {
+    double      probability{1.0};                  // share of the matching requests it applies to
+    std::size_t times{0};                          // expires once applied this many times, 0: never
+    std::chrono::microseconds latency{0};          // added before answering...
+    std::chrono::microseconds jitter{0};           // ...plus a random delay up to jitter
+    bool        long_tail{false};                  // the random delay is exponential of mean jitter, not uniform
+    int         status{0};                         // answered instead of the method, e.g. 429, 500, 503
+    long        retry_after{0};                    // seconds, sent in Retry-After with a 429
+    bool        reset{false};                      // the connection is reset without answer
+    std::size_t chunk_bytes{0};                    // the body is sent by chunks of this size...
+    std::chrono::microseconds chunk_delay{0};      // ...with this delay between them
+
+    MockFault() = default;
+
+    static MockFault delay(std::chrono::microseconds l, std::chrono::microseconds j = std::chrono::microseconds{0}, bool tail = false) {
+        MockFault fault;
+        fault.latency = l; fault.jitter = j; fault.long_tail = tail;
+        return fault;
+    }
+    static MockFault ratelimited(long seconds = 1) {
+        MockFault fault;
+        fault.status = 429; fault.retry_after = seconds;
+        return fault;
+    }
+    static MockFault server_error(int s = 500) {
+        MockFault fault;
+        fault.status = s;
+        return fault;
+    }
+    static MockFault connection_reset() {
+        MockFault fault;
+        fault.reset = true;
+        return fault;
+    }
+    static MockFault slow_body(std::size_t bytes, std::chrono::microseconds delay) {
+        MockFault fault;
+        fault.chunk_bytes = bytes; fault.chunk_delay = delay;
+        return fault;
+    }
+
+    MockFault with_probability(double p) const { auto fault = *this; fault.probability = p; return fault; }
+    MockFault only(std::size_t n) const        { auto fault = *this; fault.times = n; return fault; }
+};
+
+struct MockRequest {
+    std::string method;     // Web API method, "webhook" for the incoming webhooks, "upload" for the upload urls
+    std::string target;
+    std::map<std::string, std::string> headers; // names in lower case
+    std::string body;
+    Json        arguments;  // fields of the form or JSON body and of the query string
+};
+
+// Local stand-in for slack.com and hooks.slack.com, to point Slacking at with setBaseUrl(url()) and
+// hook.base_url = hooks_url(), or to plug in without network with set_transport(transport()). It answers api.test, auth.test, chat.postMessage/update/delete, users.list/info
+// and conversations.list/info/history/members/join with generated data and Slack's cursors, the webhooks
+// with "ok" and the external upload of files (files.getUploadURLExternal, then the upload url, then
+// files.completeUploadExternal, files.info/delete) and download of the files uploaded by url_private, with ranges.
+// apps.connections.open hands out a ws:// url of the mock, whose RFC 6455 connections play Socket Mode (see send_envelope()).
+// Request bodies may be gzipped, answers are gzipped when the client accepts it. Faults are injected per method: latency, 429 with Retry-After, 5xx, connection resets and slow bodies.
+// HTTP/1.1 with keep-alive, one thread per connection: meant for functional tests and load tests, not production.
+class MockSlack {
+public:
+    using Handler = std::function<Json(const MockRequest& request)>;
+
+    explicit MockSlack(MockOptions options = MockOptions{}) : options_(options) {}
+    ~MockSlack() { stop(); }
+
+    MockSlack(const MockSlack&)            = delete;
+    MockSlack& operator=(const MockSlack&) = delete;
+
+    // Answer a method with a handler of your own, e.g. one the mock does not know. Set it before start().
+    void on(const std::string& method, Handler handler) { handlers_[method] = handler; }
+
+    // Apply fault to the requests of method ("*" for all of them). The faults of a method are tried in the order
+    // they were injected, then those of "*": the first one whose probability draw succeeds applies, alone.
+    void inject(const std::string& method, const MockFault& fault) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        faults_.emplace_back(method, fault);
+    }
+
+    void clear_faults() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        faults_.clear();
+    }
+
+    // Requests received for method, faulty ones included
+    std::size_t calls(const std::string& method) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = calls_.find(method);
+        return it == calls_.end() ? 0 : it->second;
+    }
+
+    // Bytes read from and written to the sockets of the clients, headers included: what the network would carry
+    std::uint64_t bytes_received() const { return bytes_received_; }
+    std::uint64_t bytes_sent() const     { return bytes_sent_; }
+
+    void start();
+    void stop();
+
+    unsigned short port() const { return bound_port_; }
+    std::string url() const { return "http://" + options_.address + ':' + std::to_string(bound_port_) + "/api/"; }
+    std::string hooks_url() const { return "http://" + options_.address + ':' + std::to_string(bound_port_) + "/services/"; }
+
+    // In-memory transport to the mock for Slacking::set_transport(): no socket nor HTTP, only the costs of the
+    // client are left. Faults apply as well, a reset failing the request. Needs no start(), must not outlive the mock.
+    std::shared_ptr<Transport> transport() { return std::make_shared<MemoryTransport>(*this); }
+
+    // Socket Mode: queue an envelope ("events_api", "slash_commands", "interactive") for the newest connection,
+    // sent as soon as one is open. Return its envelope_id. As Slack, the envelopes a connection did not ack before
+    // it closed are sent again to the next one, with retry_attempt increased.
+    std::string send_envelope(const std::string& type, const Json& payload);
+    bool        acked(const std::string& envelope_id) const;
+    std::size_t socket_connections() const; // opened so far
+
+    // Send a "disconnect" message to the open connections, as Slack does before closing them
+    void disconnect_sockets(const std::string& reason = "refresh_requested");
+    // Close the open connections without a close frame, as a network failure
+    void drop_sockets();
+
+private:
+    class MemoryTransport : public Transport {
+    public:
+        explicit MemoryTransport(MockSlack& mock) : mock_(mock) {}
+        bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) override {
+            return mock_.perform(request, result, want_timing);
+        }
+        bool thread_safe() const override { return true; }
+    private:
+        MockSlack& mock_;
+    };
+
+    struct Reply {
+        int         status{200};
+        std::string content_type{"application/json; charset=utf-8"};
+        std::string body;
+        long        retry_after{0};
+        std::string headers;     // more header lines, each ending with \r\n
+
+        Reply() = default;
+        Reply(int s, const std::string& c, const std::string& b) : status{s}, content_type{c}, body{b} {}
+    };
+
+    void acceptLoop();
+    void serve(int fd);
+    bool readRequest(int fd, std::string& in, MockRequest& request, bool& keep_alive);
+    void decode(MockRequest& request);
+    bool pickFault(const std::string& method, MockFault& fault);
+    bool process(const MockRequest& request, Reply& reply, MockFault& fault);
+    void compress(const MockRequest& request, Reply& reply);
+    static bool pageKey(const MockRequest& request, std::string& key);
+    bool perform(const TransportRequest& transport_request, TransportResult& result, bool want_timing);
+    static std::string head(const Reply& reply, bool keep_alive);
+    Reply answer(const MockRequest& request);
+    Reply download(const MockRequest& request);
+    Json  page(const MockRequest& request, const std::string& collection, std::size_t total,
+               const std::function<Json(std::size_t index)>& item);
+    bool  sendAll(int fd, const char* data, std::size_t size);
+    void  pause(std::chrono::microseconds duration);
+    void  forget(int fd);
+
+    static Json user(std::size_t index) {
+        auto id = "U" + std::to_string(1000000 + index);
+        return {{"id", id}, {"name", "user" + std::to_string(index)}, {"is_bot", false}, {"deleted", false},
+                {"presence", index % 3 ? "active" : "away"},
+                {"profile", {{"email", "user" + std::to_string(index) + "@example.com"}, {"real_name", "User " + std::to_string(index)},
+                             {"image_72", "https://avatars.example.com/" + id + "_72.png"},
+                             {"image_192", "https://avatars.example.com/" + id + "_192.png"}}}};
+    }
+
+    struct MockEnvelope {
+        Json     body;
+        unsigned socket{0}; // connection it was sent on, 0: waiting for one
+        bool     acked{false};
+    };
+
+    struct MockSocket {
+        std::string disconnect_reason{}; // "disconnect" message to send
+        bool        drop{false};
+    };
+
+    void socketMode(int fd, const MockRequest& request);
+    static std::string frame(unsigned char opcode, const std::string& payload);
+    static bool nextFrame(std::string& in, unsigned char& opcode, std::string& payload);
+    static std::string websocketAccept(const std::string& key);
+
+    struct MockFile {
+        std::string                        name;
+        std::string                        title;
+        std::uint64_t                      length{0};   // announced by files.getUploadURLExternal
+        std::uint64_t                      received{0}; // by the upload url
+        std::shared_ptr<const std::string> content;     // the bytes received
+        bool                               complete{false};
+    };
+
+    Json describe(const std::string& id, const MockFile& file) const {
+        auto base = "http://" + options_.address + ':' + std::to_string(bound_port_);
+        return {{"id", id}, {"name", file.name}, {"title", file.title}, {"size", file.length},
+                {"url_private", base + "/files/" + id + '/' + file.name}, {"permalink", "https://mock.slack.com/files/U0000MOCK/" + id + '/' + file.name}};
+    }
+
+    static Json channel(std::size_t index) {
+        return {{"id", "C" + std::to_string(1000000 + index)}, {"name", "channel-" + std::to_string(index)},
+                {"is_channel", true}, {"is_archived", false}, {"num_members", 3 + index % 40}};
+    }
+
+    // a form field is always a string, a field of a JSON body may be anything
+    static std::string text(const Json& arguments, const char* key) {
+        auto it = arguments.find(key);
+        if (it == arguments.end()) { return ""; }
+        return it->is_string() ? it->get<std::string>() : it->dump();
+    }
+
+    // generated ids are a prefix then 1000000 + index
+    static bool lookup(const std::string& id, char prefix, std::size_t count, std::size_t& index) {
+        if (id.size() < 2 || id[0] != prefix) { return false; }
+        char* end = nullptr;
+        auto number = std::strtoull(id.c_str() + 1, &end, 10);
+        if (*end != '\0' || number < 1000000 || number - 1000000 >= count) { return false; }
+        index = static_cast<std::size_t>(number - 1000000);
+        return true;
+    }
+
+    static std::string timestamp(std::size_t index) {
+        return std::to_string(1700000000 + index) + ".000100";
+    }
+
+    static const char* reason(int status) {
+        switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default:  return "Unknown";
+        }
+    }
+
+    MockOptions                    options_;
+    std::map<std::string, Handler> handlers_;
+    std::vector<std::pair<std::string, MockFault>> faults_;
+    std::map<std::string, std::size_t> calls_;
+    std::map<std::string, std::string> pages_;
+    std::map<std::string, std::string> gzipped_pages_;
+    std::map<std::string, MockFile> files_;
+    std::map<std::string, MockEnvelope> envelopes_;
+    std::deque<std::string>        unsent_;         // envelope ids waiting for a connection
+    std::map<unsigned, MockSocket> sockets_;        // open Socket Mode connections by id, the newest last
+    unsigned                       next_socket_{0}; // ids of the connections opened so far
+    unsigned                       next_envelope_{0};
+    std::atomic<unsigned>          next_ts_{0};
+    std::atomic<unsigned>          next_file_{0};
+    mutable std::mutex             mutex_;
+    std::condition_variable        stopped_;
+    std::set<int>                  open_;
+    std::vector<std::thread>       threads_;
+    std::thread                    acceptor_;
+    int                            listen_fd_{-1};
+    std::atomic<bool>              stopping_{false};
+    unsigned short                 bound_port_{0};
+    std::atomic<std::uint64_t>     bytes_received_{0};
+    std::atomic<std::uint64_t>     bytes_sent_{0};
+};
+
+inline
+void MockSlack::start() {
+    if (acceptor_.joinable()) { return; }
+    stopping_ = false;
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) { throw std::runtime_error(std::string{"[slacking] socket() failed "} + std::strerror(errno)); }
+    int one = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(options_.port);
+    if (::inet_pton(AF_INET, options_.address.c_str(), &address.sin_addr) != 1) {
+        ::close(listen_fd_);
+        throw std::runtime_error("[slacking] invalid listening address " + options_.address);
+    }
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listen_fd_, SOMAXCONN) != 0) {
+        auto reason = std::string{std::strerror(errno)};
+        ::close(listen_fd_);
+        throw std::runtime_error("[slacking] cannot listen on " + options_.address + ':' + std::to_string(options_.port) + ' ' + reason);
+    }
+    socklen_t length = sizeof(address);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    bound_port_ = ntohs(address.sin_port);
+    acceptor_ = std::thread([this] { acceptLoop(); });
+}
+
+inline
+void MockSlack::stop() {
+    if (!acceptor_.joinable()) { return; }
+    stopping_ = true;
+    ::shutdown(listen_fd_, SHUT_RDWR); // wakes accept()
+    acceptor_.join();
+    ::close(listen_fd_);
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto fd : open_) { ::shutdown(fd, SHUT_RDWR); }
+        threads.swap(threads_);
+    }
+    stopped_.notify_all();
+    for (auto& thread : threads) { thread.join(); }
+}
+
+inline
+void MockSlack::acceptLoop() {
+    while (!stopping_) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+            return;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) { ::close(fd); return; }
+        open_.insert(fd);
+        threads_.emplace_back([this, fd] { serve(fd); });
+    }
+}
+
+inline
+void MockSlack::serve(int fd) {
+    std::string in;
+    MockRequest request;
+    bool keep_alive = true;
+    while (keep_alive && !stopping_ && readRequest(fd, in, request, keep_alive)) {
+        if (request.method.compare(0, 5, "/link") == 0 && request.headers["upgrade"] == "websocket") {
+            socketMode(fd, request);
+            break;
+        }
+        Reply reply;
+        MockFault fault;
+        if (!process(request, reply, fault)) {
+            linger hard{1, 0}; // close() sends RST instead of FIN
+            ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &hard, sizeof(hard));
+            break;
+        }
+        compress(request, reply);
+
+        bool sent = false;
+        if (fault.chunk_bytes > 0) {
+            auto out = head(reply, keep_alive);
+            sent = sendAll(fd, out.data(), out.size());
+            for (std::size_t offset = 0; sent && offset < reply.body.size(); offset += fault.chunk_bytes) {
+                pause(fault.chunk_delay);
+                sent = !stopping_ && sendAll(fd, reply.body.data() + offset, std::min(fault.chunk_bytes, reply.body.size() - offset));
+            }
+        }
+        else {
+            auto out = head(reply, keep_alive) + reply.body;
+            sent = sendAll(fd, out.data(), out.size());
+        }
+        if (!sent) { break; }
+    }
+    forget(fd);
+}
+
+// Fault and answer of a request, false if the connection must be reset. fault is the one applied, if any.
+inline
+bool MockSlack::process(const MockRequest& request, Reply& reply, MockFault& fault) {
+    bool faulty = pickFault(request.method, fault);
+    if (!faulty) {
+        fault = MockFault{};
+        reply = answer(request);
+        return true;
+    }
+    if (fault.reset) { return false; }
+
+    auto delay = fault.latency;
+    if (fault.jitter.count() > 0) {
+        static thread_local std::mt19937_64 generator{std::random_device{}()};
+        auto mean = static_cast<double>(fault.jitter.count());
+        auto extra = fault.long_tail ? std::exponential_distribution<double>{1 / mean}(generator)
+                                     : std::uniform_real_distribution<double>{0, mean}(generator);
+        delay += std::chrono::microseconds{static_cast<long long>(extra)};
+    }
+    pause(delay);
+
+    if (fault.status == 429) {
+        reply = Reply{429, "application/json; charset=utf-8", R"({"ok":false,"error":"ratelimited"})"};
+        reply.retry_after = fault.retry_after;
+    }
+    else if (fault.status) {
+        reply = Reply{fault.status, "text/html", std::string{"<html><body>"} + reason(fault.status) + "</body></html>"};
+    }
+    else {
+        reply = answer(request);
+    }
+    return true;
+}
+
+inline
+std::string MockSlack::head(const Reply& reply, bool keep_alive) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << reply.status << ' ' << reason(reply.status) << "\r\n"
+        << "Content-Type: " << reply.content_type << "\r\n"
+        << "Content-Length: " << reply.body.size() << "\r\n";
+    if (reply.retry_after > 0) { out << "Retry-After: " << reply.retry_after << "\r\n"; }
+    out << reply.headers << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+    return out.str();
+}
+
+inline
+bool MockSlack::perform(const TransportRequest& transport_request, TransportResult& result, bool want_timing) {
+    auto start = std::chrono::steady_clock::now();
+    auto url = transport_request.url.str();
+    auto scheme = url.find("://");
+    MockRequest request;
+    request.target = scheme == std::string::npos ? url : url.substr(std::min(url.size(), url.find('/', scheme + 3)));
+    request.headers["content-type"] = transport_request.content_type.str();
+    if (transport_request.authorization.size > 0) { request.headers["authorization"] = transport_request.authorization.str(); }
+    if (transport_request.content_encoding.size > 0) { request.headers["content-encoding"] = transport_request.content_encoding.str(); }
+    if (!(transport_request.verb == "GET")) { request.body = transport_request.body.str(); } // as curl, which sends no body with GET
+    decode(request);
+
+    Reply reply;
+    MockFault fault;
+    if (!process(request, reply, fault)) {
+        result.error = "connection reset by the mock";
+        return false;
+    }
+    if (fault.chunk_bytes > 0) { pause(fault.chunk_delay * ((reply.body.size() + fault.chunk_bytes - 1) / fault.chunk_bytes)); }
+
+    result.status_code = reply.status;
+    result.headers     = head(reply, true);
+    result.body        = std::move(reply.body);
+    if (want_timing) {
+        auto& timing = result.timing;
+        timing.url               = url;
+        timing.status_code       = result.status_code;
+        timing.total             = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        timing.starttransfer     = timing.total;
+        timing.bytes_sent        = request.body.size();
+        timing.bytes_received    = result.body.size();
+        timing.reused_connection = true;
+    }
+    return true;
+}
+
+// Read the next request of the connection, false when the connection is closed or broken
+inline
+bool MockSlack::readRequest(int fd, std::string& in, MockRequest& request, bool& keep_alive) {
+    char buffer[16384];
+    auto receive = [&]() {
+        auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) { return false; }
+        bytes_received_ += static_cast<std::uint64_t>(n);
+        in.append(buffer, static_cast<std::size_t>(n));
+        return true;
+    };
+
+    std::size_t header_end;
+    while ((header_end = in.find("\r\n\r\n")) == std::string::npos) {
+        if (in.size() > 65536 || !receive()) { return false; }
+    }
+    request = MockRequest{};
+    std::istringstream stream{in.substr(0, header_end)};
+    std::string line, verb, version;
+    std::getline(stream, line);
+    std::istringstream request_line{line};
+    request_line >> verb >> request.target >> version;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        auto colon = line.find(':');
+        if (colon == std::string::npos) { continue; }
+        auto name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        auto value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        request.headers[name] = value;
+    }
+    keep_alive = request.headers["connection"] != "close";
+    if (!request.headers["transfer-encoding"].empty()) { return false; } // curl sends a length for every Slacking body
+
+    auto length = std::strtoull(request.headers["content-length"].c_str(), nullptr, 10);
+    if (request.headers["expect"] == "100-continue" && in.size() == header_end + 4) {
+        static const char proceed[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (!sendAll(fd, proceed, sizeof(proceed) - 1)) { return false; }
+    }
+    while (in.size() < header_end + 4 + length) {
+        if (!receive()) { return false; }
+    }
+    request.body = in.substr(header_end + 4, length);
+    in.erase(0, header_end + 4 + length);
+    decode(request);
+    return true;
+}
+
+// Method and arguments of a request, from its target, content type and body
+inline
+void MockSlack::decode(MockRequest& request) {
+    auto path = request.target.substr(0, request.target.find('?'));
+    if (path.compare(0, 5, "/api/") == 0)           { request.method = path.substr(5); }
+    else if (path.compare(0, 10, "/services/") == 0) { request.method = "webhook"; }
+    else if (path.compare(0, 8, "/upload/") == 0)    { request.method = "upload"; }
+    else                                             { request.method = path; }
+
+    std::string plain;
+    if (request.headers["content-encoding"] == "gzip" && gunzip(request.body.data(), request.body.size(), plain)) { request.body.swap(plain); }
+
+    request.arguments = Json::object();
+    auto query = request.target.find('?');
+    if (query != std::string::npos) {
+        for (auto const& field : parse_form(request.target.substr(query + 1))) { request.arguments[field.first] = field.second; }
+    }
+    if (request.method == "upload") {} // file contents
+    else if (request.headers["content-type"].compare(0, 16, "application/json") == 0) {
+        auto json = Json::parse(request.body, nullptr, false);
+        if (json.is_object()) { request.arguments.update(json); }
+    }
+    else {
+        for (auto const& field : parse_form(request.body)) { request.arguments[field.first] = field.second; }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++calls_[request.method];
+}
+
+inline
+bool MockSlack::pickFault(const std::string& method, MockFault& fault) {
+    static thread_local std::mt19937_64 generator{std::random_device{}()};
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& scope : {method, std::string{"*"}}) {
+        for (auto it = faults_.begin(); it != faults_.end(); ++it) {
+            if (it->first != scope) { continue; }
+            if (it->second.probability < 1 && std::uniform_real_distribution<double>{0, 1}(generator) >= it->second.probability) { continue; }
+            fault = it->second;
+            if (it->second.times > 0 && --it->second.times == 0) { faults_.erase(it); }
+            return true;
+        }
+    }
+    return false;
+}
+
+inline
+MockSlack::Reply MockSlack::answer(const MockRequest& request) {
+    auto const& method = request.method;
+    auto const& arguments = request.arguments;
+    auto argument = [&arguments](const char* key) { return text(arguments, key); };
+    auto json = [](const Json& body) { return Reply{200, "application/json; charset=utf-8", body.dump()}; };
+    auto failure = [&json](const char* error) { return json(Json{{"ok", false}, {"error", error}}); };
+
+    if (method == "webhook") {
+        if (arguments.count("text") || arguments.count("blocks") || arguments.count("attachments")) { return Reply{200, "text/html", "ok"}; }
+        auto payload = Json::parse(argument("payload"), nullptr, false);
+        if (payload.is_object()) { return Reply{200, "text/html", "ok"}; }
+        return Reply{400, "text/html", "invalid_payload"};
+    }
+    if (method == "upload") { // the upload url is signed: no token
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto file = files_.find(request.target.substr(8, request.target.find('?') - 8));
+        if (file == files_.end()) { return Reply{404, "text/plain", "Not Found"}; }
+        file->second.received = request.body.size();
+        file->second.content  = std::make_shared<const std::string>(request.body); // served back by url_private
+        return Reply{200, "text/plain", "OK - " + std::to_string(request.body.size())};
+    }
+
+    auto handler = handlers_.find(method);
+    if (handler != handlers_.end()) { return json(handler->second(request)); }
+
+    if (method == "api.test") {
+        auto args = arguments;
+        args.erase("token");
+        return json(Json{{"ok", true}, {"args", args}});
+    }
+
+    if (method.compare(0, 7, "/files/") == 0) { return download(request); }
+
+    if (!options_.token.empty()) {
+        auto token = argument("token");
+        auto authorization = request.headers.find("authorization");
+        if (authorization != request.headers.end() && authorization->second.compare(0, 7, "Bearer ") == 0) { token = authorization->second.substr(7); }
+        if (token.empty())                { return failure("not_authed"); }
+        if (token != options_.token)      { return failure("invalid_auth"); }
+    }
+
+    if (method == "apps.connections.open") {
+        return json(Json{{"ok", true}, {"url", "ws://" + options_.address + ':' + std::to_string(bound_port_) + "/link/?ticket=mock"}});
+    }
+    if (method == "auth.test") {
+        return json(Json{{"ok", true}, {"url", "https://mock.slack.com/"}, {"team", "Mock"}, {"user", "bot"},
+                         {"team_id", "T0000MOCK"}, {"user_id", "U0000MOCK"}, {"bot_id", "B0000MOCK"}});
+    }
+    if (method == "chat.postMessage") {
+        if (argument("channel").empty()) { return failure("channel_not_found"); }
+        if (argument("text").empty() && !arguments.count("blocks") && !arguments.count("attachments")) { return failure("no_text"); }
+        auto ts = timestamp(next_ts_++);
+        return json(Json{{"ok", true}, {"channel", argument("channel")}, {"ts", ts},
+                         {"message", {{"type", "message"}, {"user", "U0000MOCK"}, {"bot_id", "B0000MOCK"}, {"text", argument("text")}, {"ts", ts}}}});
+    }
+    if (method == "chat.update" || method == "chat.delete") {
+        if (argument("channel").empty()) { return failure("channel_not_found"); }
+        if (argument("ts").empty())      { return failure("message_not_found"); }
+        Json body = {{"ok", true}, {"channel", argument("channel")}, {"ts", argument("ts")}};
+        if (method == "chat.update") { body["text"] = argument("text"); }
+        return json(body);
+    }
+    if (method == "files.getUploadURLExternal") {
+        if (argument("filename").empty()) { return failure("invalid_arguments"); }
+        MockFile file;
+        file.name   = argument("filename");
+        file.title  = file.name;
+        file.length = std::strtoull(argument("length").c_str(), nullptr, 10);
+        auto id = "F" + std::to_string(1000000 + next_file_++);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            files_[id] = file;
+        }
+        auto upload_url = "http://" + options_.address + ':' + std::to_string(bound_port_) + "/upload/" + id;
+        return json(Json{{"ok", true}, {"upload_url", upload_url}, {"file_id", id}});
+    }
+    if (method == "files.completeUploadExternal") {
+        auto files = arguments.count("files") && arguments["files"].is_array() ? arguments["files"] : Json::parse(argument("files"), nullptr, false);
+        if (!files.is_array() || files.empty()) { return failure("invalid_arguments"); }
+        Json completed = Json::array();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto const& entry : files) {
+            auto id = entry.is_object() ? entry.value("id", "") : "";
+            auto file = files_.find(id);
+            if (file == files_.end() || file->second.received != file->second.length) { return failure("file_not_found"); }
+            file->second.complete = true;
+            if (entry.count("title") && entry["title"].is_string()) { file->second.title = entry["title"].get<std::string>(); }
+            completed.push_back(describe(id, file->second));
+        }
+        return json(Json{{"ok", true}, {"files", completed}});
+    }
+    if (method == "files.info" || method == "files.delete") {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto file = files_.find(argument("file"));
+        if (file == files_.end() || !file->second.complete) { return failure("file_not_found"); }
+        if (method == "files.delete") {
+            files_.erase(file);
+            return json(Json{{"ok", true}});
+        }
+        return json(Json{{"ok", true}, {"file", describe(file->first, file->second)}});
+    }
+
+    // the generated pages never change: each one is rendered once
+    std::string key;
+    if (pageKey(request, key)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto cached = pages_.find(key);
+        if (cached != pages_.end()) { return Reply{200, "application/json; charset=utf-8", cached->second}; }
+    }
+    auto cache = [this, &key](Reply reply) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pages_[key] = reply.body;
+        return reply;
+    };
+
+    if (method == "users.list") {
+        return cache(json(page(request, "members", options_.users, user)));
+    }
+    if (method == "users.info") {
+        std::size_t index;
+        return lookup(argument("user"), 'U', options_.users, index) ? json(Json{{"ok", true}, {"user", user(index)}}) : failure("user_not_found");
+    }
+    if (method == "conversations.list") {
+        return cache(json(page(request, "channels", options_.channels, channel)));
+    }
+
+    // the conversations.* methods below work on an existing channel
+    std::size_t index = 0;
+    bool known = lookup(argument("channel"), 'C', options_.channels, index);
+    if (method == "conversations.info" || method == "conversations.join") {
+        return known ? json(Json{{"ok", true}, {"channel", channel(index)}}) : failure("channel_not_found");
+    }
+    if (method == "conversations.history") {
+        if (!known) { return failure("channel_not_found"); }
+        auto total = options_.messages;
+        auto body = page(request, "messages", total, [total](std::size_t i) { // newest first, as Slack
+            auto ts = timestamp(total - i);
+            return Json{{"type", "message"}, {"user", "U" + std::to_string(1000000 + i % 7)}, {"text", "message " + std::to_string(total - i)}, {"ts", ts}};
+        });
+        body["has_more"] = !body["response_metadata"]["next_cursor"].get<std::string>().empty();
+        return cache(json(body));
+    }
+    if (method == "conversations.members") {
+        if (!known) { return failure("channel_not_found"); }
+        auto total = std::min<std::size_t>(options_.users, channel(index)["num_members"].get<std::size_t>());
+        return cache(json(page(request, "members", total, [](std::size_t i) { return user(i)["id"]; })));
+    }
+    return Reply{404, "application/json; charset=utf-8", R"({"ok":false,"error":"unknown_method"})"};
+}
+
+// url_private of an uploaded file: the bot token in the Authorization header, one range of bytes or all of them.
+// As Slack, a request without the right token gets a login page rather than an error.
+inline
+MockSlack::Reply MockSlack::download(const MockRequest& request) {
+    auto authorization = request.headers.find("authorization");
+    if (!options_.token.empty() && (authorization == request.headers.end() || authorization->second != "Bearer " + options_.token)) {
+        return Reply{200, "text/html", "<html><body>Sign in to Mock</body></html>"};
+    }
+    auto path = request.target.substr(7, request.target.find('?') - 7);
+    std::shared_ptr<const std::string> file_content;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto file = files_.find(path.substr(0, path.find('/')));
+        if (file == files_.end() || !file->second.complete || !file->second.content) { return Reply{404, "text/plain", "Not Found"}; }
+        file_content = file->second.content;
+    }
+    auto const& content = *file_content;
+
+    auto range = request.headers.find("range");
+    if (range == request.headers.end()) { return Reply{200, "application/octet-stream", content}; }
+    std::uint64_t first = 0, last = content.size() - 1;
+    char* end = nullptr;
+    if (range->second.compare(0, 6, "bytes=") == 0) {
+        first = std::strtoull(range->second.c_str() + 6, &end, 10);
+        if (*end == '-' && end[1] != '\0') { last = std::min<std::uint64_t>(last, std::strtoull(end + 1, nullptr, 10)); }
+    }
+    if (!end || *end != '-' || content.empty() || first > last) {
+        Reply reply{416, "text/plain", ""};
+        reply.headers = "Content-Range: bytes */" + std::to_string(content.size()) + "\r\n";
+        return reply;
+    }
+    Reply reply{206, "application/octet-stream", content.substr(first, last - first + 1)};
+    reply.headers = "Content-Range: bytes " + std::to_string(first) + '-' + std::to_string(last) + '/' + std::to_string(content.size()) + "\r\n";
+    return reply;
+}
+
+// One page of a paginated method: the cursor is the offset of the page, as opaque to clients as Slack's ones
+inline
+Json MockSlack::page(const MockRequest& request, const std::string& collection, std::size_t total,
+                     const std::function<Json(std::size_t index)>& item) {
+    std::size_t limit = std::strtoul(text(request.arguments, "limit").c_str(), nullptr, 10);
+    if (limit == 0) { limit = options_.page_size; }
+    auto cursor = text(request.arguments, "cursor");
+    std::size_t first = cursor.compare(0, 7, "offset:") == 0 ? std::strtoul(cursor.c_str() + 7, nullptr, 10) : 0;
+
+    Json items = Json::array();
+    for (auto i = first; i < std::min<std::size_t>(total, first + limit); ++i) { items.push_back(item(i)); }
+    auto next = first + limit < total ? "offset:" + std::to_string(first + limit) : std::string{};
+    return Json{{"ok", true}, {collection, items}, {"response_metadata", {{"next_cursor", next}}}};
+}
+
+// As slack.com, answers of 1 KiB or more are gzipped for the clients accepting it. The pages, once.
+inline
+void MockSlack::compress(const MockRequest& request, Reply& reply) {
+    auto accepted = request.headers.find("accept-encoding");
+    if (reply.status != 200 || reply.body.size() < 1024 || accepted == request.headers.end() || accepted->second.find("gzip") == std::string::npos) { return; }
+    std::string key, body;
+    bool page = pageKey(request, key);
+    if (page) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto cached = gzipped_pages_.find(key);
+        if (cached != gzipped_pages_.end()) { body = cached->second; }
+    }
+    if (body.empty()) {
+        body = gzip(reply.body.data(), reply.body.size(), Z_DEFAULT_COMPRESSION);
+        if (page) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            gzipped_pages_[key] = body;
+        }
+    }
+    reply.body = std::move(body);
+    reply.headers += "Content-Encoding: gzip\r\n";
+}
+
+// Whether the method answers generated pages, which never change, and the key of the page asked
+inline
+bool MockSlack::pageKey(const MockRequest& request, std::string& key) {
+    auto const& method = request.method;
+    if (method != "users.list" && method != "conversations.list" && method != "conversations.history" && method != "conversations.members") { return false; }
+    key = method + ' ' + text(request.arguments, "channel") + ' ' + text(request.arguments, "cursor") + ' ' + text(request.arguments, "limit");
+    return true;
+}
+
+inline
+bool MockSlack::sendAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        bytes_sent_ += static_cast<std::uint64_t>(n);
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+inline
+std::string MockSlack::send_envelope(const std::string& type, const Json& payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto id = "E" + std::to_string(1000000 + next_envelope_++);
+    MockEnvelope envelope;
+    envelope.body = {{"envelope_id", id}, {"type", type}, {"payload", payload}, {"accepts_response_payload", type != "events_api"},
+                     {"retry_attempt", 0}, {"retry_reason", ""}};
+    envelopes_[id] = envelope;
+    unsent_.push_back(id);
+    return id;
+}
+
+inline
+bool MockSlack::acked(const std::string& envelope_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = envelopes_.find(envelope_id);
+    return it != envelopes_.end() && it->second.acked;
+}
+
+inline
+std::size_t MockSlack::socket_connections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_socket_;
+}
+
+inline
+void MockSlack::disconnect_sockets(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& socket : sockets_) { socket.second.disconnect_reason = reason; }
+}
+
+inline
+void MockSlack::drop_sockets() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& socket : sockets_) { socket.second.drop = true; }
+}
+
+// Socket Mode over an upgraded connection: hello, then the queued envelopes and the disconnect messages, while
+// reading the acks. Everything is sent from the thread of the connection, which polls the queue between reads.
+inline
+void MockSlack::socketMode(int fd, const MockRequest& request) {
+    auto key = request.headers.find("sec-websocket-key");
+    if (key == request.headers.end()) {
+        auto out = head(Reply{400, "text/plain", ""}, false);
+        sendAll(fd, out.data(), out.size());
+        return;
+    }
+    auto upgrade = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                   "Sec-WebSocket-Accept: " + websocketAccept(key->second) + "\r\n\r\n";
+    if (!sendAll(fd, upgrade.data(), upgrade.size())) { return; }
+
+    unsigned id;
+    std::size_t connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = ++next_socket_;
+        sockets_[id] = MockSocket{};
+        connections = sockets_.size();
+    }
+    auto send = [this, fd](unsigned char opcode, const std::string& payload) {
+        auto out = frame(opcode, payload);
+        return sendAll(fd, out.data(), out.size());
+    };
+    Json hello = {{"type", "hello"}, {"num_connections", connections}, {"connection_info", {{"app_id", "A0000MOCK"}}},
+                  {"debug_info", {{"host", "mock"}, {"approximate_connection_time", 18060}}}};
+    bool alive = send(0x1, hello.dump());
+    bool dropped = false;
+    std::string in, payload;
+    char buffer[16384];
+
+    while (alive && !stopping_) {
+        std::vector<std::string> out;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& socket = sockets_[id];
+            if (socket.drop) { dropped = true; break; }
+            if (!socket.disconnect_reason.empty()) {
+                out.push_back(Json{{"type", "disconnect"}, {"reason", socket.disconnect_reason}, {"debug_info", {{"host", "mock"}}}}.dump());
+                socket.disconnect_reason.clear();
+            }
+            if (id == sockets_.rbegin()->first) {
+                for (auto const& envelope_id : unsent_) {
+                    auto& envelope = envelopes_[envelope_id];
+                    envelope.socket = id;
+                    out.push_back(envelope.body.dump());
+                }
+                unsent_.clear();
+            }
+        }
+        for (auto const& text : out) { alive = alive && send(0x1, text); }
+
+        pollfd readable{fd, POLLIN, 0};
+        if (alive && ::poll(&readable, 1, 10) > 0) {
+            auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) { break; }
+            bytes_received_ += static_cast<std::uint64_t>(n);
+            in.append(buffer, static_cast<std::size_t>(n));
+        }
+        unsigned char opcode;
+        while (alive && nextFrame(in, opcode, payload)) {
+            if (opcode == 0x1) {
+                auto ack = Json::parse(payload, nullptr, false);
+                if (!ack.is_object() || !ack.count("envelope_id") || !ack["envelope_id"].is_string()) { continue; }
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto envelope = envelopes_.find(ack["envelope_id"].get<std::string>());
+                if (envelope != envelopes_.end()) { envelope->second.acked = true; }
+            }
+            else if (opcode == 0x8) { // close: answered, then the connection ends
+                send(0x8, payload.substr(0, 2));
+                alive = false;
+            }
+            else if (opcode == 0x9) {
+                alive = send(0xA, payload);
+            }
+        }
+    }
+    if (dropped) {
+        linger hard{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &hard, sizeof(hard));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sockets_.erase(id);
+    for (auto& envelope : envelopes_) {
+        if (envelope.second.socket != id || envelope.second.acked) { continue; }
+        envelope.second.socket = 0;
+        envelope.second.body["retry_attempt"] = envelope.second.body["retry_attempt"].get<int>() + 1;
+        envelope.second.body["retry_reason"]  = "timeout";
+        unsent_.push_back(envelope.first);
+    }
+}
+
+// Frame sent by the server: never masked, never fragmented
+inline
+std::string MockSlack::frame(unsigned char opcode, const std::string& payload) {
+    std::string out(1, static_cast<char>(0x80 | opcode));
+    auto size = payload.size();
+    if (size < 126) {
+        out += static_cast<char>(size);
+    }
+    else if (size <= 0xffff) {
+        out += static_cast<char>(126);
+        out += static_cast<char>(size >> 8);
+        out += static_cast<char>(size & 0xff);
+    }
+    else {
+        out += static_cast<char>(127);
+        for (int i = 7; i >= 0; --i) { out += static_cast<char>((static_cast<std::uint64_t>(size) >> (8 * i)) & 0xff); }
+    }
+    return out + payload;
+}
+
+// Extract one frame sent by the client from in, false if it is not complete yet
+inline
+bool MockSlack::nextFrame(std::string& in, unsigned char& opcode, std::string& payload) {
+    if (in.size() < 2) { return false; }
+    std::uint64_t size = static_cast<unsigned char>(in[1]) & 0x7f;
+    std::size_t header = 2;
+    if (size == 126 || size == 127) {
+        std::size_t extra = size == 126 ? 2 : 8;
+        if (in.size() < header + extra) { return false; }
+        size = 0;
+        for (std::size_t i = 0; i < extra; ++i) { size = size << 8 | static_cast<unsigned char>(in[header + i]); }
+        header += extra;
+    }
+    bool masked = (static_cast<unsigned char>(in[1]) & 0x80) != 0;
+    if (masked) { header += 4; }
+    if (in.size() < header + size) { return false; }
+
+    opcode = static_cast<unsigned char>(in[0]) & 0x0f;
+    payload.assign(in, header, static_cast<std::size_t>(size));
+    if (masked) {
+        for (std::size_t i = 0; i < payload.size(); ++i) { payload[i] = static_cast<char>(payload[i] ^ in[header - 4 + (i & 3)]); }
+    }
+    in.erase(0, header + static_cast<std::size_t>(size));
+    return true;
+}
+
+// base64 of the SHA-1 of key and the GUID of RFC 6455
+inline
+std::string MockSlack::websocketAccept(const std::string& key) {
+    auto message = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    auto bits = static_cast<std::uint64_t>(message.size()) * 8;
+    message += '\x80';
+    while (message.size() % 64 != 56) { message += '\0'; }
+    for (int i = 7; i >= 0; --i) { message += static_cast<char>((bits >> (8 * i)) & 0xff); }
+
+    std::uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    auto rotate = [](std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    for (std::size_t block = 0; block < message.size(); block += 64) {
+        std::uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = 0;
+            for (int j = 0; j < 4; ++j) { w[i] = w[i] << 8 | static_cast<unsigned char>(message[block + 4 * i + j]); }
+        }
+        for (int i = 16; i < 80; ++i) { w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1); }
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            std::uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            auto t = rotate(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rotate(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    unsigned char digest[20];
+    for (int i = 0; i < 20; ++i) { digest[i] = static_cast<unsigned char>(h[i / 4] >> (24 - 8 * (i % 4))); }
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (int i = 0; i < 20; i += 3) {
+        std::uint32_t n = std::uint32_t(digest[i]) << 16 | std::uint32_t(digest[i + 1]) << 8 | (i + 2 < 20 ? digest[i + 2] : 0);
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += table[(n >> 6) & 63];
+        out += i + 2 < 20 ? table[n & 63] : '=';
+    }
+    return out;
+}
+
+// Sleep, cut short by stop()
+inline
+void MockSlack::pause(std::chrono::microseconds duration) {
+    if (duration.count() <= 0) { return; }
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopped_.wait_for(lock, duration, [this] { return stopping_.load(); });
+}
+
+inline
+void MockSlack::forget(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_.erase(fd); // before close(): stop() must not shut down a descriptor number reused meanwhile
+    ::close(fd);
+}
+
+} // namespace _detail
+
+using _detail::MockOptions;
+using _detail::MockFault;
+using _detail::MockRequest;
+using _detail::MockSlack;
+
+} // namespace slack
+
+#endif // SLACKING_MOCK_SERVER_HPP_
@@ -0,0 +1,654 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: local full-text index of Slack messages.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_SEARCH_INDEX_HPP_
+#define SLACKING_SEARCH_INDEX_HPP_
+
+#include "slacking.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+
+#if defined(_WIN32)
+# include <iterator>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace slack {
+
+namespace _detail {
+
+// Split a message text into lowercase tokens. ASCII letters and digits form tokens, other ASCII
+// characters separate them and non-ASCII bytes are kept so that UTF-8 words are indexed as they are.
+template<typename F>
+void tokenize(const std::string& text, F on_token) {
+    static const std::size_t max_token = 64;
+    std::string token;
+    for (auto c : text) {
+        auto u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || std::isalnum(u)) {
+            if (token.size() < max_token) { token += static_cast<char>(u < 0x80 ? std::tolower(u) : u); }
+        }
+        else if (!token.empty()) {
+            on_token(token);
+            token.clear();
+        }
+    }
+    if (!token.empty()) { on_token(token); }
+}
+
+// Slack timestamps ("1512085950.000216") are stored as microseconds
+inline
+std::int64_t ts_to_micros(const std::string& ts) {
+    auto dot = ts.find('.');
+    std::int64_t seconds = std::strtoll(ts.c_str(), nullptr, 10);
+    std::int64_t micros = 0;
+    if (dot != std::string::npos) {
+        auto fraction = ts.substr(dot + 1, 6);
+        fraction.resize(6, '0');
+        micros = std::strtoll(fraction.c_str(), nullptr, 10);
+    }
+    return seconds * 1000000 + micros;
+}
+
+inline
+std::string micros_to_ts(std::int64_t micros) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%lld.%06lld", static_cast<long long>(micros / 1000000), static_cast<long long>(micros % 1000000));
+    return buffer;
+}
+
+namespace index_format {
+
+// Segment file layout, all integers little endian:
+//   header    magic "SLKIDX01", u32 doc_count, u32 term_count, u32 string_count, u32 reserved,
+//             u64 strings_offset, u64 docs_offset, u64 terms_offset, u64 blob_offset, u64 file_size
+//   strings   string_count x { u64 offset, u32 length, u32 reserved }         sorted, channel and user ids
+//   docs      doc_count x { u32 channel, u32 user, i64 ts_micros, u64 text_offset, u32 text_length, u32 reserved }
+//   terms     term_count x { u64 offset, u32 length, u32 doc_frequency, u64 postings_offset, u32 postings_length, u32 reserved }  sorted
+//   blob      string bytes, message texts, term bytes and postings
+// Postings are varint encoded deltas of increasing doc ids.
+static const char        magic[8]     = {'S', 'L', 'K', 'I', 'D', 'X', '0', '1'};
+static const std::size_t header_size  = 64;
+static const std::size_t string_size  = 16;
+static const std::size_t doc_size     = 32;
+static const std::size_t term_size    = 32;
+
+inline void put_u32(std::string& out, std::uint32_t v) { for (int i = 0; i < 4; ++i) { out += static_cast<char>((v >> (8 * i)) & 0xff); } }
+inline void put_u64(std::string& out, std::uint64_t v) { for (int i = 0; i < 8; ++i) { out += static_cast<char>((v >> (8 * i)) & 0xff); } }
+
+inline std::uint32_t get_u32(const unsigned char* p) {
+    return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+}
+inline std::uint64_t get_u64(const unsigned char* p) { return std::uint64_t(get_u32(p)) | (std::uint64_t(get_u32(p + 4)) << 32); }
+
+inline void put_varint(std::string& out, std::uint32_t v) {
+    while (v >= 0x80) { out += static_cast<char>((v & 0x7f) | 0x80); v >>= 7; }
+    out += static_cast<char>(v);
+}
+
+} // namespace index_format
+
+// Flush a file, or the entries of a directory, to the disk. Windows: left to the system.
+inline
+void sync_path(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { throw std::runtime_error("[slacking] cannot open " + path); }
+    auto synced = ::fsync(fd) == 0;
+    ::close(fd);
+    if (!synced) { throw std::runtime_error("[slacking] cannot sync " + path); }
+#else
+    ignore_unused_parameter(path);
+#endif
+}
+
+// Read-only view of a whole file, mapped in memory where possible
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { throw std::runtime_error("[slacking] cannot open " + path); }
+        buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data_ = reinterpret_cast<const unsigned char*>(buffer_.data());
+        size_ = buffer_.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("[slacking] cannot open " + path); }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) { ::close(fd); throw std::runtime_error("[slacking] cannot stat " + path); }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) { ::close(fd); throw std::runtime_error("[slacking] cannot map " + path); }
+            data_ = static_cast<const unsigned char*>(mapped);
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (data_ != nullptr) { ::munmap(const_cast<unsigned char*>(data_), size_); }
+#endif
+    }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_{nullptr};
+    std::size_t          size_{0};
+#if defined(_WIN32)
+    std::string          buffer_;
+#endif
+};
+
+// Line of a HistoryExporter NDJSON file
+struct ArchivedMessage {
+    std::string channel;
+    std::string user;
+    std::string bot_id;
+    std::string ts;
+    std::string text;
+
+    static const std::vector<FieldBinding<ArchivedMessage>>& fields() {
+        static const std::vector<FieldBinding<ArchivedMessage>> bindings = {
+            field("channel", &ArchivedMessage::channel), field("user", &ArchivedMessage::user), field("bot_id", &ArchivedMessage::bot_id),
+            field("ts", &ArchivedMessage::ts), field("text", &ArchivedMessage::text)
+        };
+        return bindings;
+    }
+};
+
+struct SearchQuery {
+    std::string   text;       // every token must match
+    std::string   channel;    // optional channel id filter
+    std::string   user;       // optional user id filter
+    std::string   oldest;     // optional, inclusive Slack timestamp
+    std::string   latest;     // optional, inclusive Slack timestamp
+    std::size_t   limit;
+
+    SearchQuery(const std::string& t = "", const std::string& c = "", const std::string& u = "",
+                const std::string& o = "", const std::string& l = "", std::size_t n = 50)
+        : text{t}, channel{c}, user{u}, oldest{o}, latest{l}, limit{n} {}
+};
+
+struct SearchHit {
+    std::string channel;
+    std::string user;
+    std::string ts;
+    std::string text;
+};
+
+// Documents not yet written to disk, searchable right away
+class SegmentBuilder {
+public:
+    struct Doc {
+        std::string   channel;
+        std::string   user;
+        std::int64_t  ts;
+        std::string   text;
+    };
+
+    void add(const std::string& channel, const std::string& user, const std::string& ts, const std::string& text) {
+        auto id = static_cast<std::uint32_t>(docs_.size());
+        docs_.push_back(Doc{channel, user, ts_to_micros(ts), text});
+        tokenize(text, [&](const std::string& token) {
+            auto& postings = postings_[token];
+            if (postings.empty() || postings.back() != id) { postings.push_back(id); }
+        });
+    }
+
+    bool empty() const { return docs_.empty(); }
+    std::size_t size() const { return docs_.size(); }
+    const Doc& doc(std::uint32_t id) const { return docs_[id]; }
+
+    const std::vector<std::uint32_t>* postings(const std::string& term) const {
+        auto it = postings_.find(term);
+        return it == postings_.end() ? nullptr : &it->second;
+    }
+
+    void clear() { docs_.clear(); postings_.clear(); }
+
+    // Write the segment to path, aside then renamed
+    void write(const std::string& path) const;
+
+private:
+    std::vector<Doc> docs_;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> postings_;
+};
+
+inline
+void SegmentBuilder::write(const std::string& path) const {
+    using namespace index_format;
+
+    std::vector<std::string> strings;
+    for (auto const& doc : docs_) { strings.push_back(doc.channel); strings.push_back(doc.user); }
+    std::sort(strings.begin(), strings.end());
+    strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+    auto string_id = [&](const std::string& s) {
+        return static_cast<std::uint32_t>(std::lower_bound(strings.begin(), strings.end(), s) - strings.begin());
+    };
+
+    std::vector<const std::pair<const std::string, std::vector<std::uint32_t>>*> terms;
+    terms.reserve(postings_.size());
+    for (auto const& entry : postings_) { terms.push_back(&entry); }
+    std::sort(terms.begin(), terms.end(), [](decltype(terms[0]) a, decltype(terms[0]) b) { return a->first < b->first; });
+
+    std::string blob, strings_table, docs_table, terms_table;
+    for (auto const& s : strings) {
+        put_u64(strings_table, blob.size()); put_u32(strings_table, static_cast<std::uint32_t>(s.size())); put_u32(strings_table, 0);
+        blob += s;
+    }
+    for (auto const& doc : docs_) {
+        put_u32(docs_table, string_id(doc.channel)); put_u32(docs_table, string_id(doc.user));
+        put_u64(docs_table, static_cast<std::uint64_t>(doc.ts));
+        put_u64(docs_table, blob.size()); put_u32(docs_table, static_cast<std::uint32_t>(doc.text.size())); put_u32(docs_table, 0);
+        blob += doc.text;
+    }
+    for (auto const term : terms) {
+        put_u64(terms_table, blob.size()); put_u32(terms_table, static_cast<std::uint32_t>(term->first.size()));
+        put_u32(terms_table, static_cast<std::uint32_t>(term->second.size()));
+        blob += term->first;
+        auto postings_offset = blob.size();
+        std::uint32_t previous = 0;
+        for (auto id : term->second) { put_varint(blob, id - previous); previous = id; }
+        put_u64(terms_table, postings_offset); put_u32(terms_table, static_cast<std::uint32_t>(blob.size() - postings_offset)); put_u32(terms_table, 0);
+    }
+
+    std::uint64_t strings_offset = header_size;
+    std::uint64_t docs_offset    = strings_offset + strings_table.size();
+    std::uint64_t terms_offset   = docs_offset + docs_table.size();
+    std::uint64_t blob_offset    = terms_offset + terms_table.size();
+    std::uint64_t file_size      = blob_offset + blob.size();
+
+    std::string header(magic, sizeof(magic));
+    put_u32(header, static_cast<std::uint32_t>(docs_.size())); put_u32(header, static_cast<std::uint32_t>(terms.size()));
+    put_u32(header, static_cast<std::uint32_t>(strings.size())); put_u32(header, 0);
+    put_u64(header, strings_offset); put_u64(header, docs_offset); put_u64(header, terms_offset); put_u64(header, blob_offset); put_u64(header, file_size);
+    header.resize(header_size, '\0');
+
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file << header << strings_table << docs_table << terms_table << blob;
+        if (!file.flush()) { throw std::runtime_error("[slacking] cannot write " + tmp_path); }
+    }
+    sync_path(tmp_path); // on disk before a manifest may list it
+    if (!replace_file(tmp_path, path)) { throw std::runtime_error("[slacking] cannot rename " + tmp_path); }
+    sync_path(path.substr(0, path.rfind('/')));
+}
+
+// Immutable segment read in place from its mapped file
+class Segment {
+public:
+    explicit Segment(const std::string& path) : path_{path}, file_{path} {
+        using namespace index_format;
+        auto data = file_.data();
+        if (file_.size() < header_size || std::memcmp(data, magic, sizeof(magic)) != 0) { corrupted(); }
+        doc_count_      = get_u32(data + 8);
+        term_count_     = get_u32(data + 12);
+        string_count_   = get_u32(data + 16);
+        strings_offset_ = get_u64(data + 24);
+        docs_offset_    = get_u64(data + 32);
+        terms_offset_   = get_u64(data + 40);
+        blob_offset_    = get_u64(data + 48);
+        if (get_u64(data + 56) != file_.size()
+            || strings_offset_ + std::uint64_t(string_count_) * string_size != docs_offset_
+            || docs_offset_ + std::uint64_t(doc_count_) * doc_size != terms_offset_
+            || terms_offset_ + std::uint64_t(term_count_) * term_size != blob_offset_
+            || blob_offset_ > file_.size()) { corrupted(); }
+    }
+
+    const std::string& path() const { return path_; }
+    std::uint32_t doc_count() const { return doc_count_; }
+
+    std::uint32_t doc_channel(std::uint32_t id) const { return index_format::get_u32(doc_entry(id)); }
+    std::uint32_t doc_user(std::uint32_t id) const    { return index_format::get_u32(doc_entry(id) + 4); }
+    std::int64_t  doc_ts(std::uint32_t id) const      { return static_cast<std::int64_t>(index_format::get_u64(doc_entry(id) + 8)); }
+    std::string   doc_text(std::uint32_t id) const {
+        auto entry = doc_entry(id);
+        return blob(index_format::get_u64(entry + 16), index_format::get_u32(entry + 24));
+    }
+
+    std::string string_at(std::uint32_t id) const {
+        auto entry = file_.data() + strings_offset_ + std::uint64_t(id) * index_format::string_size;
+        return blob(index_format::get_u64(entry), index_format::get_u32(entry + 8));
+    }
+
+    // Id of a channel or user id in this segment, false if absent
+    bool find_string(const std::string& s, std::uint32_t& id) const {
+        std::uint32_t low = 0, high = string_count_;
+        while (low < high) {
+            auto mid = low + (high - low) / 2;
+            auto cmp = string_at(mid).compare(s);
+            if (cmp == 0) { id = mid; return true; }
+            if (cmp < 0) { low = mid + 1; } else { high = mid; }
+        }
+        return false;
+    }
+
+    // Decode the postings of term, false if the term is absent
+    bool postings(const std::string& term, std::vector<std::uint32_t>& ids) const {
+        using namespace index_format;
+        std::uint32_t low = 0, high = term_count_;
+        while (low < high) {
+            auto mid = low + (high - low) / 2;
+            auto entry = file_.data() + terms_offset_ + std::uint64_t(mid) * term_size;
+            auto cmp = compare(get_u64(entry), get_u32(entry + 8), term);
+            if (cmp == 0) {
+                ids.clear();
+                ids.reserve(get_u32(entry + 12));
+                auto p   = bytes(get_u64(entry + 16), get_u32(entry + 24));
+                auto end = p + get_u32(entry + 24);
+                std::uint32_t id = 0;
+                while (p < end) {
+                    std::uint32_t delta = 0;
+                    for (int shift = 0; p < end; shift += 7) {
+                        delta |= std::uint32_t(*p & 0x7f) << shift;
+                        if (!(*p++ & 0x80)) { break; }
+                    }
+                    id += delta;
+                    if (id >= doc_count_) { corrupted(); }
+                    ids.push_back(id);
+                }
+                return true;
+            }
+            if (cmp < 0) { low = mid + 1; } else { high = mid; }
+        }
+        return false;
+    }
+
+private:
+    [[noreturn]] void corrupted() const { throw std::runtime_error("[slacking] corrupted index segment " + path_); }
+
+    const unsigned char* doc_entry(std::uint32_t id) const {
+        return file_.data() + docs_offset_ + std::uint64_t(id) * index_format::doc_size;
+    }
+
+    const unsigned char* bytes(std::uint64_t offset, std::uint32_t length) const {
+        if (blob_offset_ + offset + length > file_.size()) { corrupted(); }
+        return file_.data() + blob_offset_ + offset;
+    }
+
+    std::string blob(std::uint64_t offset, std::uint32_t length) const {
+        return std::string(reinterpret_cast<const char*>(bytes(offset, length)), length);
+    }
+
+    int compare(std::uint64_t offset, std::uint32_t length, const std::string& s) const {
+        auto p = reinterpret_cast<const char*>(bytes(offset, length));
+        auto cmp = std::memcmp(p, s.data(), std::min<std::size_t>(length, s.size()));
+        if (cmp != 0) { return cmp; }
+        return length < s.size() ? -1 : (length > s.size() ? 1 : 0);
+    }
+
+    std::string   path_;
+    MappedFile    file_;
+    std::uint32_t doc_count_{0}, term_count_{0}, string_count_{0};
+    std::uint64_t strings_offset_{0}, docs_offset_{0}, terms_offset_{0}, blob_offset_{0};
+};
+
+// Local full-text index of messages, stored in a directory as immutable mapped segments listed in a manifest.
+// add() makes a message searchable at once, commit() writes the pending messages as a new segment and
+// compact() merges every segment into one. Queries never touch Slack.
+class SearchIndex {
+public:
+    explicit SearchIndex(const std::string& directory) : directory_{directory} {
+        std::ifstream file(manifest_path());
+        if (!file) { return; }
+        auto manifest = Json::parse(file, nullptr, false);
+        if (manifest.is_discarded()) { throw std::runtime_error("[slacking] corrupted index manifest " + manifest_path()); }
+        next_segment_ = manifest.value("next_segment", 1u);
+        for (auto const& name : manifest["segments"]) {
+            segments_.emplace_back(new Segment{directory_ + '/' + name.get<std::string>()});
+        }
+    }
+
+    void add(const std::string& channel, const Message& message) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.add(channel, message.user.empty() ? message.bot_id : message.user, message.ts, message.text);
+    }
+
+    void add(const std::string& channel, const std::string& user, const std::string& ts, const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.add(channel, user, ts, text);
+    }
+
+    // Index every message of an NDJSON file written by HistoryExporter
+    std::size_t add_ndjson(const std::string& path);
+
+    void commit();
+    void compact();
+
+    std::vector<SearchHit> search(const SearchQuery& query) const;
+
+    std::size_t segment_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return segments_.size();
+    }
+
+private:
+    std::string manifest_path() const { return directory_ + "/index.manifest"; }
+    std::string segment_name(unsigned number) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "segment-%06u.idx", number);
+        return name;
+    }
+    void saveManifest() const;
+
+    template<typename Source>
+    void searchSource(Source source, const std::vector<std::string>& terms, const SearchQuery& query, std::vector<SearchHit>& hits) const;
+
+    std::string                           directory_;
+    mutable std::mutex                    mutex_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+    SegmentBuilder                        pending_;
+    unsigned                              next_segment_{1};
+};
+
+// Uniform access to the documents of a mapped segment and of the pending builder for searchSource.
+// prepare() resolves the filters of the query, it returns false when no document can match.
+struct SegmentSource {
+    const Segment& segment;
+    std::uint32_t  channel_id{0};
+    std::uint32_t  user_id{0};
+
+    explicit SegmentSource(const Segment& s) : segment(s) {}
+
+    std::uint32_t size() const { return segment.doc_count(); }
+    bool postings(const std::string& term, std::vector<std::uint32_t>& ids) const { return segment.postings(term, ids); }
+    bool prepare(const SearchQuery& query) {
+        return (query.channel.empty() || segment.find_string(query.channel, channel_id))
+            && (query.user.empty() || segment.find_string(query.user, user_id));
+    }
+    bool accept(std::uint32_t id, const SearchQuery& query) const {
+        return (query.channel.empty() || segment.doc_channel(id) == channel_id)
+            && (query.user.empty() || segment.doc_user(id) == user_id);
+    }
+    std::int64_t ts(std::uint32_t id) const { return segment.doc_ts(id); }
+    SearchHit hit(std::uint32_t id) const {
+        return SearchHit{segment.string_at(segment.doc_channel(id)), segment.string_at(segment.doc_user(id)), micros_to_ts(segment.doc_ts(id)), segment.doc_text(id)};
+    }
+};
+
+struct BuilderSource {
+    const SegmentBuilder& builder;
+
+    explicit BuilderSource(const SegmentBuilder& b) : builder(b) {}
+
+    std::uint32_t size() const { return static_cast<std::uint32_t>(builder.size()); }
+    bool postings(const std::string& term, std::vector<std::uint32_t>& ids) const {
+        auto found = builder.postings(term);
+        if (found == nullptr) { return false; }
+        ids = *found;
+        return true;
+    }
+    bool prepare(const SearchQuery&) { return true; }
+    bool accept(std::uint32_t id, const SearchQuery& query) const {
+        auto const& doc = builder.doc(id);
+        return (query.channel.empty() || doc.channel == query.channel) && (query.user.empty() || doc.user == query.user);
+    }
+    std::int64_t ts(std::uint32_t id) const { return builder.doc(id).ts; }
+    SearchHit hit(std::uint32_t id) const {
+        auto const& doc = builder.doc(id);
+        return SearchHit{doc.channel, doc.user, micros_to_ts(doc.ts), doc.text};
+    }
+};
+
+template<typename Source>
+void SearchIndex::searchSource(Source source, const std::vector<std::string>& terms, const SearchQuery& query, std::vector<SearchHit>& hits) const {
+    if (!source.prepare(query)) { return; }
+    std::int64_t oldest = query.oldest.empty() ? std::numeric_limits<std::int64_t>::min() : ts_to_micros(query.oldest);
+    std::int64_t latest = query.latest.empty() ? std::numeric_limits<std::int64_t>::max() : ts_to_micros(query.latest);
+
+    std::vector<std::uint32_t> candidates, postings, intersection;
+    if (terms.empty()) {
+        candidates.resize(source.size());
+        for (std::uint32_t id = 0; id < source.size(); ++id) { candidates[id] = id; }
+    }
+    for (std::size_t t = 0; t < terms.size(); ++t) {
+        if (!source.postings(terms[t], postings)) { return; }
+        if (t == 0) { candidates.swap(postings); continue; }
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(), postings.begin(), postings.end(), std::back_inserter(intersection));
+        candidates.swap(intersection);
+        if (candidates.empty()) { return; }
+    }
+
+    // only the newest `limit` matches of the source are materialized
+    std::vector<std::pair<std::int64_t, std::uint32_t>> matches;
+    for (auto id : candidates) {
+        if (!source.accept(id, query)) { continue; }
+        auto ts = source.ts(id);
+        if (ts < oldest || ts > latest) { continue; }
+        matches.emplace_back(ts, id);
+    }
+    auto limit = std::min(query.limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), std::greater<std::pair<std::int64_t, std::uint32_t>>());
+    for (std::size_t i = 0; i < limit; ++i) { hits.push_back(source.hit(matches[i].second)); }
+}
+
+inline
+std::vector<SearchHit> SearchIndex::search(const SearchQuery& query) const {
+    std::vector<std::string> terms;
+    tokenize(query.text, [&](const std::string& token) { terms.push_back(token); });
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    std::vector<SearchHit> hits;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto const& segment : segments_) { searchSource(SegmentSource{*segment}, terms, query, hits); }
+        searchSource(BuilderSource{pending_}, terms, query, hits);
+    }
+
+    // newest first
+    auto limit = std::min(query.limit, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + limit, hits.end(), [](const SearchHit& a, const SearchHit& b) {
+        return ts_to_micros(a.ts) > ts_to_micros(b.ts);
+    });
+    hits.resize(limit);
+    return hits;
+}
+
+inline
+std::size_t SearchIndex::add_ndjson(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) { throw std::runtime_error("[slacking] cannot open " + path); }
+    std::size_t count = 0;
+    std::string line;
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (std::getline(file, line)) {
+        auto decoded = decode<ArchivedMessage>("{\"message\":" + line + "}", "message");
+        if (decoded.items.empty()) { continue; }
+        auto const& m = decoded.items.front();
+        pending_.add(m.channel, m.user.empty() ? m.bot_id : m.user, m.ts, m.text);
+        ++count;
+    }
+    return count;
+}
+
+inline
+void SearchIndex::commit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) { return; }
+    auto path = directory_ + '/' + segment_name(next_segment_++);
+    pending_.write(path);
+    segments_.emplace_back(new Segment{path});
+    saveManifest();
+    pending_.clear();
+}
+
+inline
+void SearchIndex::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.size() + (pending_.empty() ? 0 : 1) <= 1) { return; }
+    SegmentBuilder merged;
+    for (auto const& segment : segments_) {
+        for (std::uint32_t id = 0; id < segment->doc_count(); ++id) {
+            merged.add(segment->string_at(segment->doc_channel(id)), segment->string_at(segment->doc_user(id)),
+                       micros_to_ts(segment->doc_ts(id)), segment->doc_text(id));
+        }
+    }
+    for (std::uint32_t id = 0; id < pending_.size(); ++id) {
+        auto const& doc = pending_.doc(id);
+        merged.add(doc.channel, doc.user, micros_to_ts(doc.ts), doc.text);
+    }
+    auto path = directory_ + '/' + segment_name(next_segment_++);
+    merged.write(path);
+
+    std::vector<std::string> obsolete;
+    for (auto const& segment : segments_) { obsolete.push_back(segment->path()); }
+    segments_.clear();
+    segments_.emplace_back(new Segment{path});
+    pending_.clear();
+    saveManifest();
+    for (auto const& old : obsolete) { std::remove(old.c_str()); }
+}
+
+// written aside, synced then renamed over the previous one: the manifest is the commit point of the index,
+// a crash leaves the old list of segments or the new one
+inline
+void SearchIndex::saveManifest() const {
+    Json manifest = {{"next_segment", next_segment_}, {"segments", Json::array()}};
+    for (auto const& segment : segments_) {
+        auto const& path = segment->path();
+        manifest["segments"].push_back(path.substr(path.rfind('/') + 1));
+    }
+    auto tmp_path = manifest_path() + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << manifest.dump();
+        if (!file.flush()) { throw std::runtime_error("[slacking] cannot write " + tmp_path); }
+    }
+    sync_path(tmp_path);
+    if (!replace_file(tmp_path, manifest_path())) { throw std::runtime_error("[slacking] cannot rename " + tmp_path); }
+    sync_path(directory_);
+}
+
+} // namespace _detail
+
+using _detail::SearchQuery;
+using _detail::SearchHit;
+using _detail::SearchIndex;
+
+} // namespace slack
+
+#endif // SLACKING_SEARCH_INDEX_HPP_
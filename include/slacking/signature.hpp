@@ -0,0 +1,247 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: verification of the signature of requests sent by Slack.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_SIGNATURE_HPP_
+#define SLACKING_SIGNATURE_HPP_
+
+#include "slacking.hpp"
+
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+// Streaming SHA-256 (FIPS 180-4). The state can be copied to resume a hash from a common prefix.
+class Sha256 {
+public:
+    using Digest = std::array<unsigned char, 32>;
+
+    Sha256() { reset(); }
+
+    void reset() {
+        static const std::uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        std::memcpy(state_, init, sizeof(state_));
+        length_ = 0;
+        buffered_ = 0;
+    }
+
+    void update(const void* data, std::size_t size) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        length_ += size;
+        if (buffered_ > 0) {
+            auto take = std::min(size, sizeof(buffer_) - buffered_);
+            std::memcpy(buffer_ + buffered_, bytes, take);
+            buffered_ += take; bytes += take; size -= take;
+            if (buffered_ < sizeof(buffer_)) { return; }
+            compress(buffer_);
+            buffered_ = 0;
+        }
+        for (; size >= 64; bytes += 64, size -= 64) { compress(bytes); }
+        std::memcpy(buffer_, bytes, size);
+        buffered_ = size;
+    }
+
+    void update(const std::string& data) { update(data.data(), data.size()); }
+
+    Digest finish() {
+        std::uint64_t bits = length_ * 8;
+        unsigned char padding[72] = {0x80};
+        auto pad = (buffered_ < 56 ? 56 : 120) - buffered_;
+        for (int i = 0; i < 8; ++i) { padding[pad + i] = static_cast<unsigned char>(bits >> (56 - 8 * i)); }
+        update(padding, pad + 8);
+        Digest digest;
+        for (int i = 0; i < 8; ++i) {
+            for (int j = 0; j < 4; ++j) { digest[4 * i + j] = static_cast<unsigned char>(state_[i] >> (24 - 8 * j)); }
+        }
+        return digest;
+    }
+
+private:
+    static std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const unsigned char* block) {
+        static const std::uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (std::uint32_t(block[4 * i]) << 24) | (std::uint32_t(block[4 * i + 1]) << 16) | (std::uint32_t(block[4 * i + 2]) << 8) | block[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto a = state_[0], b = state_[1], c = state_[2], d = state_[3], e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+        for (int i = 0; i < 64; ++i) {
+            auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+        state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+        state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+    }
+
+    std::uint32_t state_[8];
+    unsigned char buffer_[64];
+    std::uint64_t length_;
+    std::size_t   buffered_;
+};
+
+// HMAC-SHA256 whose key schedule is computed once: the hash states after the inner and outer
+// padded keys are kept and copied for every message instead of hashing the key again.
+class HmacSha256 {
+public:
+    explicit HmacSha256(const std::string& key) {
+        unsigned char block[64] = {0};
+        if (key.size() > sizeof(block)) {
+            Sha256 hashed; hashed.update(key);
+            auto digest = hashed.finish();
+            std::memcpy(block, digest.data(), digest.size());
+        }
+        else {
+            std::memcpy(block, key.data(), key.size());
+        }
+        unsigned char pad[64];
+        for (int i = 0; i < 64; ++i) { pad[i] = block[i] ^ 0x36; }
+        inner_.update(pad, sizeof(pad));
+        for (int i = 0; i < 64; ++i) { pad[i] = block[i] ^ 0x5c; }
+        outer_.update(pad, sizeof(pad));
+    }
+
+    // Start a MAC: feed the message to the returned hash then call finish()
+    Sha256 begin() const { return inner_; }
+
+    Sha256::Digest finish(Sha256& inner) const {
+        auto inner_digest = inner.finish();
+        auto outer = outer_;
+        outer.update(inner_digest.data(), inner_digest.size());
+        return outer.finish();
+    }
+
+    Sha256::Digest mac(const std::string& message) const {
+        auto inner = begin();
+        inner.update(message);
+        return finish(inner);
+    }
+
+private:
+    Sha256 inner_;
+    Sha256 outer_;
+};
+
+// Verify the X-Slack-Signature of inbound requests (https://api.slack.com/authentication/verifying-requests-from-slack):
+// HMAC-SHA256 of "v0:<X-Slack-Request-Timestamp>:<body>" keyed with the signing secret, compared in constant time.
+// Two secrets can be active at once to rotate the signing secret without rejecting requests, and requests
+// whose timestamp is outside the window are rejected to prevent replays. Safe to share between threads.
+class SignatureVerifier {
+public:
+    explicit SignatureVerifier(const std::string& signing_secret, std::chrono::seconds window = std::chrono::seconds{300})
+        : window_{window} {
+        set_secrets(signing_secret);
+    }
+
+    // previous_secret may be empty
+    void set_secrets(const std::string& current_secret, const std::string& previous_secret = "") {
+        std::shared_ptr<const Keys> keys = std::make_shared<Keys>(current_secret, previous_secret);
+        std::atomic_store(&keys_, keys);
+    }
+
+    // The current secret is still accepted until drop_previous()
+    void rotate(const std::string& new_secret) {
+        std::lock_guard<std::mutex> lock(rotation_mutex_);
+        auto keys = std::atomic_load(&keys_);
+        set_secrets(new_secret, keys->current_secret);
+    }
+
+    void drop_previous() {
+        std::lock_guard<std::mutex> lock(rotation_mutex_);
+        auto keys = std::atomic_load(&keys_);
+        set_secrets(keys->current_secret);
+    }
+
+    bool verify(const std::string& timestamp, const std::string& body, const std::string& signature) const {
+        return verify(timestamp, body, signature, static_cast<long long>(std::time(nullptr)));
+    }
+
+    bool verify(const std::string& timestamp, const std::string& body, const std::string& signature, long long now) const {
+        char* end = nullptr;
+        auto ts = std::strtoll(timestamp.c_str(), &end, 10);
+        if (timestamp.empty() || *end != '\0') { return false; }
+        if (ts < now - window_.count() || ts > now + window_.count()) { return false; }
+
+        Sha256::Digest expected;
+        if (!parse(signature, expected)) { return false; }
+
+        auto keys = std::atomic_load(&keys_);
+        return matches(keys->current, timestamp, body, expected)
+            || (keys->has_previous && matches(keys->previous, timestamp, body, expected));
+    }
+
+private:
+    struct Keys {
+        std::string current_secret;
+        HmacSha256  current;
+        HmacSha256  previous;
+        bool        has_previous;
+
+        Keys(const std::string& c, const std::string& p) : current_secret{c}, current{c}, previous{p}, has_previous{!p.empty()} {}
+    };
+
+    // "v0=" followed by 64 hexadecimal digits
+    static bool parse(const std::string& signature, Sha256::Digest& digest) {
+        if (signature.size() != 3 + 2 * digest.size() || signature.compare(0, 3, "v0=") != 0) { return false; }
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') { return c - '0'; }
+            if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+            if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+            return -1;
+        };
+        for (std::size_t i = 0; i < digest.size(); ++i) {
+            int high = nibble(signature[3 + 2 * i]), low = nibble(signature[4 + 2 * i]);
+            if (high < 0 || low < 0) { return false; }
+            digest[i] = static_cast<unsigned char>(high << 4 | low);
+        }
+        return true;
+    }
+
+    static bool matches(const HmacSha256& key, const std::string& timestamp, const std::string& body, const Sha256::Digest& expected) {
+        auto inner = key.begin();
+        inner.update("v0:", 3);
+        inner.update(timestamp);
+        inner.update(":", 1);
+        inner.update(body);
+        auto actual = key.finish(inner);
+        unsigned char difference = 0;
+        for (std::size_t i = 0; i < actual.size(); ++i) { difference |= actual[i] ^ expected[i]; }
+        return difference == 0;
+    }
+
+    std::chrono::seconds        window_;
+    std::shared_ptr<const Keys> keys_;
+    std::mutex                  rotation_mutex_;
+};
+
+} // namespace _detail
+
+using _detail::Sha256;
+using _detail::HmacSha256;
+using _detail::SignatureVerifier;
+
+} // namespace slack
+
+#endif // SLACKING_SIGNATURE_HPP_
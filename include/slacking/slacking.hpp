@@ -32,6 +32,22 @@
 #include <vector>
 #include <sstream>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
 
 #ifndef CURL_STATICLIB
 # include <curl/curl.h>
@@ -39,7 +55,15 @@
 # include "curl/curl.h"
 #endif
 
+// json.hpp falls through an assertion which NDEBUG compiles out: silenced for it alone
+#if defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#endif
 #include "json.hpp"  // nlohmann/json
+#if defined(__GNUC__)
+# pragma GCC diagnostic pop
+#endif
 
 
 #if SLACKING_VERBOSE_OUTPUT
@@ -53,10 +77,248 @@ namespace _detail {
 // Json
 using Json = nlohmann::json;
 
+// Network timing of a request as measured by curl. Every duration is counted from the start of the request,
+// so DNS is namelookup, TCP connect - namelookup, TLS appconnect - connect, Slack's own time roughly
+// starttransfer - pretransfer and the download of the body total - starttransfer.
+struct RequestTiming {
+    std::string               url;
+    long                      status_code;
+    std::chrono::microseconds namelookup;
+    std::chrono::microseconds connect;
+    std::chrono::microseconds appconnect;    // 0 without TLS or on a reused connection
+    std::chrono::microseconds pretransfer;
+    std::chrono::microseconds starttransfer; // first byte of the response
+    std::chrono::microseconds total;
+    std::uint64_t             bytes_sent;
+    std::uint64_t             bytes_received;
+    bool                      reused_connection;
+};
+
 struct Response {
     std::string text;
     bool        is_error;
     std::string error_message;
+    long        status_code;
+    long        retry_after;   // seconds, from the Retry-After header sent along a 429
+    RequestTiming timing;      // only filled when a timing hook or a recorder is set
+};
+
+// A request and its answer, as recorded and replayed (see trace.hpp)
+struct Exchange {
+    std::string   verb;              // GET or POST
+    std::string   url;
+    std::string   request_body;
+    long          status_code;
+    std::string   response_headers;  // raw, as received
+    std::string   response_body;
+    RequestTiming timing;
+};
+
+// Thrown instead of a plain runtime_error when Slack answers HTTP 429
+class RateLimited : public std::runtime_error {
+public:
+    RateLimited(long retry_after) 
+        : std::runtime_error{"ratelimited (retry after " + std::to_string(retry_after) + "s)"}, retry_after_{retry_after} {}
+    long retry_after() const { return retry_after_; }
+private:
+    long retry_after_;
+};
+
+// Slack rate limit tiers (https://api.slack.com/docs/rate-limits). Limits apply per method and per workspace.
+enum class RateTier { Tier1, Tier2, Tier3, Tier4, Special };
+
+// Blocking rate limiter keyed by method, following the generic cell rate algorithm.
+// Each method may start a burst of `burst` calls then is paced at the rate of its tier.
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RateLimiter() {
+        set_rate(RateTier::Tier1, 1);
+        set_rate(RateTier::Tier2, 20);
+        set_rate(RateTier::Tier3, 50);
+        set_rate(RateTier::Tier4, 100);
+        set_rate(RateTier::Special, 60); // e.g. chat.postMessage, roughly one message per second
+    }
+
+    void set_rate(RateTier tier, double per_minute, unsigned burst = 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& rate = rates_[static_cast<std::size_t>(tier)];
+        rate.interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(60.0 / per_minute));
+        rate.burst = burst == 0 ? 1 : burst;
+    }
+
+    // Block until a call to method is allowed
+    void acquire(const std::string& method, RateTier tier) {
+        auto wait = reserve(method, tier);
+        if (wait > Clock::duration::zero()) { std::this_thread::sleep_for(wait); }
+    }
+
+    // Take a slot only if it is available right now
+    bool try_acquire(const std::string& method, RateTier tier) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& rate = rates_[static_cast<std::size_t>(tier)];
+        auto& tat  = tats_[method];
+        auto now   = Clock::now();
+        if (tat - rate.interval * (rate.burst - 1) > now) { return false; }
+        tat = std::max(tat, now) + rate.interval;
+        return true;
+    }
+
+    // Hold every call to method for retry_after seconds, as asked by a 429
+    void penalize(const std::string& method, long retry_after) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& tat = tats_[method];
+        tat = std::max(tat, Clock::now() + std::chrono::seconds{retry_after});
+    }
+
+private:
+    Clock::duration reserve(const std::string& method, RateTier tier) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& rate = rates_[static_cast<std::size_t>(tier)];
+        auto& tat  = tats_[method];
+        auto now   = Clock::now();
+        auto allowed_at = tat - rate.interval * (rate.burst - 1);
+        tat = std::max(tat, now) + rate.interval;
+        return allowed_at - now;
+    }
+
+    struct Rate {
+        Clock::duration interval{};
+        unsigned        burst{1};
+    };
+
+    std::mutex  mutex_;
+    Rate        rates_[5];
+    std::unordered_map<std::string, Clock::time_point> tats_;
+};
+
+enum class HttpVerb { Get, Post };
+
+// How the arguments of a method are sent: form encoded (every method) or as a Json body (methods taking blocks)
+enum class ArgumentEncoding { Form, Json };
+
+// Compile time description of a Web API method, see the catalog of methods.hpp and Slacking::call().
+// index identifies the method in the catalog: custom descriptors take indexes past methods::count.
+struct MethodDescriptor {
+    std::size_t        index;
+    const char*        name;
+    HttpVerb           verb;
+    RateTier           tier;
+    ArgumentEncoding   encoding;
+    const char* const* required;       // arguments to give besides the token
+    std::size_t        required_count;
+};
+
+// Queue whose content is bounded by a total cost (e.g. bytes) shared between producer and consumer threads
+template<typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(std::size_t capacity) : capacity_{capacity} {}
+
+    // Block while the queue is full. An item bigger than the capacity is accepted when the queue is empty.
+    // Return false if the queue has been closed.
+    bool push(T item, std::size_t cost = 1) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]{ return closed_ || used_ == 0 || used_ + cost <= capacity_; });
+        if (closed_) { return false; }
+        items_.emplace_back(std::move(item), cost);
+        used_ += cost;
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool try_push(T item, std::size_t cost = 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || (used_ != 0 && used_ + cost > capacity_)) { return false; }
+        items_.emplace_back(std::move(item), cost);
+        used_ += cost;
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Block until an item is available. Return false once the queue is closed and drained.
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&]{ return closed_ || !items_.empty(); });
+        if (items_.empty()) { return false; }
+        item = std::move(items_.front().first);
+        used_ -= items_.front().second;
+        items_.pop_front();
+        not_full_.notify_all();
+        return true;
+    }
+
+    // As pop(), giving up at deadline. Return false on timeout too: closed() tells both cases apart.
+    bool pop_until(T& item, std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_until(lock, deadline, [&]{ return closed_ || !items_.empty(); });
+        if (items_.empty()) { return false; }
+        item = std::move(items_.front().first);
+        used_ -= items_.front().second;
+        items_.pop_front();
+        not_full_.notify_all();
+        return true;
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    mutable std::mutex      mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<std::pair<T, std::size_t>> items_;
+    std::size_t             capacity_;
+    std::size_t             used_{0};
+    bool                    closed_{false};
+};
+
+// Fixed set of threads running tasks from a bounded queue. submit() never blocks: a full pool refuses the task.
+class WorkerPool {
+public:
+    WorkerPool(unsigned threads, std::size_t capacity) : queue_{capacity} {
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+            threads_.emplace_back([this] {
+                std::function<void()> task;
+                while (queue_.pop(task)) {
+                    try { task(); }
+                    catch (std::exception& e) { std::cerr << "[slacking] handler failed. Reason: " << e.what() << '\n'; }
+                    catch (...) { std::cerr << "[slacking] handler failed.\n"; }
+                }
+            });
+        }
+    }
+
+    ~WorkerPool() { shutdown(); }
+
+    bool submit(std::function<void()> task) { return queue_.try_push(std::move(task)); }
+
+    // Run the tasks already queued then join the threads
+    void shutdown() {
+        queue_.close();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) { thread.join(); }
+        }
+    }
+
+private:
+    BlockingQueue<std::function<void()>> queue_;
+    std::vector<std::thread>             threads_;
 };
 
 
@@ -72,6 +334,8 @@ public:
         /* CURLcode rc = curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, element); */
     }
 
+    struct curl_slist* list() const { return element; }
+
     ~curl_header()  {
         // free the custom headers  
         curl_slist_free_all(element);
@@ -83,19 +347,299 @@ private:
 
 };
 
-// Simple curl Session inspired by CPR
-class Session {
+// Put the file written aside at from in place of to. POSIX rename() replaces to atomically: a crash leaves
+// either file whole. Windows' one refuses an existing target, which is removed first there.
+inline
+bool replace_file(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+    std::remove(to.c_str());
+#endif
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+// Non owning view on bytes (std::string_view is C++17)
+struct BufferView {
+    const char* data{nullptr};
+    std::size_t size{0};
+
+    BufferView() = default;
+    BufferView(const char* d, std::size_t s) : data{d}, size{s} {}
+    BufferView(const std::string& s) : data{s.data()}, size{s.size()} {}
+
+    bool operator==(const char* text) const { return std::strlen(text) == size && std::equal(data, data + size, text); }
+    std::string str() const { return data ? std::string(data, size) : std::string{}; }
+};
+
+// A request handed to a transport: views on the buffers of the session, valid until perform() returns
+struct TransportRequest {
+    BufferView verb;          // GET or POST
+    BufferView url;           // null terminated
+    BufferView content_type;
+    BufferView authorization; // value of the Authorization header, none when empty
+    BufferView body;
+    BufferView content_encoding; // of the body, e.g. gzip (see compression.hpp), none when empty. May be left out
+};
+
+// What the transport received. The headers and the body are written straight into these strings, which the
+// Response then takes over: no transport needs a buffer of its own.
+struct TransportResult {
+    long          status_code{0};
+    std::string   headers;    // raw, as received
+    std::string   body;
+    std::string   error;      // why no answer was received (DNS, connection, TLS...)
+    RequestTiming timing{};   // only filled when asked for
+};
+
+// How a Session sends its requests: libcurl by default (CurlTransport), or e.g. the in-memory transport of
+// MockSlack (mock_server.hpp), a TraceReplayer (trace.hpp) or a network stack of your own.
+// It costs one virtual call per request, nothing next to a round trip. A transport shared between sessions
+// must be thread safe. A session calls a transport which is not thread_safe() from one thread at a time.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // false when no answer was received, result.error telling why
+    virtual bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) = 0;
+
+    virtual void set_proxy(const std::string& url) { (void)url; }
+
+    // Ask for compressed answers (gzip, deflate and the other encodings libcurl was built with), decompressed as
+    // they are received: the body handed to the parser is the plain Json
+    virtual void set_accept_encoding(bool accept) { (void)accept; }
+
+    // true if perform() may run from many threads at once: the session then sends concurrent requests in parallel
+    virtual bool thread_safe() const { return false; }
+};
+
+// DNS and TLS session caches shared by the easy handles of many CurlTransports: a handle opening a connection
+// to slack.com neither resolves it again nor makes a full TLS handshake. Thread safe.
+// Connections are not shared: libcurl's shared connection cache cannot be used from concurrent threads.
+class CurlShare {
 public:
-    Session(bool throw_exception) : throw_exception_{throw_exception} {
+    CurlShare() {
         curl_global_init(CURL_GLOBAL_ALL);
-        curl_ = curl_easy_init();
+        share_ = curl_share_init();
+        if (!share_) { return; }
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
     }
-    Session(bool throw_exception, std::string proxy_url) : throw_exception_{ throw_exception } {
+    ~CurlShare() { curl_share_cleanup(share_); curl_global_cleanup(); }
+
+    CurlShare(const CurlShare&)            = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+
+    CURLSH* handle() const { return share_; }
+
+private:
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* self) {
+        static_cast<CurlShare*>(self)->mutexes_[data].lock();
+    }
+    static void unlock(CURL*, curl_lock_data data, void* self) {
+        static_cast<CurlShare*>(self)->mutexes_[data].unlock();
+    }
+
+    CURLSH*    share_;
+    std::mutex mutexes_[CURL_LOCK_DATA_LAST];
+};
+
+// A libcurl easy handle, which keeps the connection alive between requests
+class CurlTransport : public Transport {
+public:
+    explicit CurlTransport(std::shared_ptr<CurlShare> share = nullptr) : share_{share} {
         curl_global_init(CURL_GLOBAL_ALL);
         curl_ = curl_easy_init();
+        if (curl_ && share_ && share_->handle()) { curl_easy_setopt(curl_, CURLOPT_SHARE, share_->handle()); }
+    }
+    ~CurlTransport() { curl_easy_cleanup(curl_); curl_global_cleanup(); }
+
+    CurlTransport(const CurlTransport&)            = delete;
+    CurlTransport& operator=(const CurlTransport&) = delete;
+
+    bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) override;
+
+    void set_proxy(const std::string& url) override {
+        proxy_url_ = url; 
+        if (nullptr != curl_)   curl_easy_setopt(curl_, CURLOPT_PROXY, proxy_url_.c_str());
+    }
+
+    void set_accept_encoding(bool accept) override {
+        if (curl_) { curl_easy_setopt(curl_, CURLOPT_ACCEPT_ENCODING, accept ? "" : nullptr); } // "": every encoding supported
+    }
+
+private:
+    void readTiming(RequestTiming& timing, CURLcode res);
+
+    static size_t writeFunction(void* ptr, size_t size, size_t nmemb, std::string* data) {
+        data->append((char*) ptr, size * nmemb);
+        return size * nmemb;
+    }
+
+    std::shared_ptr<CurlShare> share_; // outlives curl_
+    CURL*       curl_;
+    std::string proxy_url_;
+};
+
+inline
+bool CurlTransport::perform(const TransportRequest& request, TransportResult& result, bool want_timing) {
+    if (!curl_) { result.error = "curl_easy_init() failed"; return false; }
+
+    if (request.verb == "GET") {
+        curl_easy_setopt(curl_, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl_, CURLOPT_NOBODY, 0L);
+    }
+    else {
+        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size));
+        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, request.body.data ? request.body.data : "");
+    }
+
+    //------ set our custom set of headers
+    // for  using incoming webhook it is mandatory to set 
+    // "Content-Type: application/x-www-form-urlencoded" in header
+
+    curl_header  header(curl_);
+    bool custom_header = !(request.content_type == "application/x-www-form-urlencoded");
+    if (custom_header) { header.append("Content-Type: " + request.content_type.str()); }
+    if (request.authorization.size > 0) {
+        header.append("Authorization: " + request.authorization.str());
+        custom_header = true;
+    }
+    if (request.content_encoding.size > 0) {
+        header.append("Content-Encoding: " + request.content_encoding.str());
+        custom_header = true;
+    }
+    if (custom_header) { curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, header.list()); }
+    
+    //-------- set our custom set of headers------------------------------  
+
+    curl_easy_setopt(curl_, CURLOPT_URL, request.url.data);
+    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeFunction);
+    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &result.body);
+    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &result.headers);
+
+    auto res = curl_easy_perform(curl_);
+    if (custom_header) { curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, nullptr); } // the list is freed with header
+
+    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &result.status_code);
+    if (want_timing) {
+        readTiming(result.timing, res);
+        result.timing.url = request.url.str();
+    }
+    if (res != CURLE_OK) {
+        result.error = "curl_easy_perform() failed " + std::string{curl_easy_strerror(res)};
+        return false;
+    }
+    return true;
+}
+
+inline
+void CurlTransport::readTiming(RequestTiming& timing, CURLcode res) {
+    auto duration = [this](CURLINFO info) {
+        curl_off_t microseconds = 0;
+        curl_easy_getinfo(curl_, info, &microseconds);
+        return std::chrono::microseconds{microseconds};
+    };
+    auto bytes = [this](CURLINFO info) {
+        curl_off_t count = 0;
+        curl_easy_getinfo(curl_, info, &count);
+        return static_cast<std::uint64_t>(count);
+    };
+    long new_connections = 0;
+    curl_easy_getinfo(curl_, CURLINFO_NUM_CONNECTS, &new_connections);
+    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &timing.status_code);
+
+    timing.namelookup        = duration(CURLINFO_NAMELOOKUP_TIME_T);
+    timing.connect           = duration(CURLINFO_CONNECT_TIME_T);
+    timing.appconnect        = duration(CURLINFO_APPCONNECT_TIME_T);
+    timing.pretransfer       = duration(CURLINFO_PRETRANSFER_TIME_T);
+    timing.starttransfer     = duration(CURLINFO_STARTTRANSFER_TIME_T);
+    timing.total             = duration(CURLINFO_TOTAL_TIME_T);
+    timing.bytes_sent        = bytes(CURLINFO_SIZE_UPLOAD_T);
+    timing.bytes_received    = bytes(CURLINFO_SIZE_DOWNLOAD_T);
+    timing.reused_connection = new_connections == 0 && res == CURLE_OK;
+}
+
+// Transport lending its easy handles to the sessions of many Slacking instances, or to the threads sharing one.
+// A handle goes back to the pool after each request with its connection alive, for the next request of any
+// session or thread: a few connections serve hundreds of workspaces (see client_pool.hpp). Every handle shares
+// the DNS and TLS session caches of the pool. Thread safe.
+class PooledCurlTransport : public Transport {
+public:
+    // max_idle bounds the handles, thus the connections, kept alive between requests
+    explicit PooledCurlTransport(std::size_t max_idle = 16) : share_{std::make_shared<CurlShare>()}, max_idle_{max_idle} {}
+
+    PooledCurlTransport(const PooledCurlTransport&)            = delete;
+    PooledCurlTransport& operator=(const PooledCurlTransport&) = delete;
+
+    bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) override {
+        auto handle = checkout();
+        auto answered = handle->perform(request, result, want_timing);
+        checkin(std::move(handle));
+        return answered;
+    }
+
+    void set_proxy(const std::string& url) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        proxy_url_ = url;
+        for (auto& handle : idle_) { handle->set_proxy(proxy_url_); }
+    }
+
+    void set_accept_encoding(bool accept) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accept_encoding_ = accept;
+        for (auto& handle : idle_) { handle->set_accept_encoding(accept_encoding_); }
+    }
+
+    bool thread_safe() const override { return true; }
+
+    std::size_t idle() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+
+private:
+    std::unique_ptr<CurlTransport> checkout() {
+        std::string proxy_url;
+        bool accept_encoding;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                auto handle = std::move(idle_.back());
+                idle_.pop_back();
+                return handle;
+            }
+            proxy_url = proxy_url_;
+            accept_encoding = accept_encoding_;
+        }
+        std::unique_ptr<CurlTransport> handle{new CurlTransport{share_}}; // opened outside the lock
+        if (!proxy_url.empty()) { handle->set_proxy(proxy_url); }
+        if (accept_encoding)    { handle->set_accept_encoding(true); }
+        return handle;
+    }
+
+    void checkin(std::unique_ptr<CurlTransport> handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle_) { idle_.push_back(std::move(handle)); }
+    }
+
+    std::shared_ptr<CurlShare>                  share_;
+    std::size_t                                 max_idle_;
+    mutable std::mutex                          mutex_;
+    std::vector<std::unique_ptr<CurlTransport>> idle_;
+    std::string                                 proxy_url_;
+    bool                                        accept_encoding_{false};
+};
+
+// Simple Session inspired by CPR, sending its requests through a Transport (libcurl unless told otherwise)
+class Session {
+public:
+    Session(bool throw_exception) : transport_{std::make_shared<CurlTransport>()}, throw_exception_{throw_exception} {}
+    Session(bool throw_exception, std::shared_ptr<Transport> transport) : transport_{transport}, throw_exception_{throw_exception} {}
+    Session(bool throw_exception, std::string proxy_url) : transport_{std::make_shared<CurlTransport>()}, throw_exception_{ throw_exception } {
         SetProxyUrl(proxy_url);
     }
-    ~Session() { curl_easy_cleanup(curl_); curl_global_cleanup(); }
 
     void SetUrl(const std::string& url) { url_ = url;   }
 
@@ -106,96 +650,129 @@ public:
  
     void SetProxyUrl(const std::string& url) {
         proxy_url_ = url; 
-        if (nullptr != curl_)   curl_easy_setopt(curl_, CURLOPT_PROXY, proxy_url_.c_str());
+        transport_->set_proxy(proxy_url_);
+    }
+
+    void SetAcceptEncoding(bool accept) {
+        accept_encoding_ = accept;
+        transport_->set_accept_encoding(accept_encoding_);
+    }
+
+    // Like the hooks, set before the session is shared between threads
+    void SetTransport(std::shared_ptr<Transport> transport) {
+        std::lock_guard<std::mutex> lock(mutex_request_);
+        transport_ = transport;
+        if (!proxy_url_.empty()) { transport_->set_proxy(proxy_url_); }
+        if (accept_encoding_)    { transport_->set_accept_encoding(true); }
     }
 
-    void SetBody(const std::string& data);
+    std::shared_ptr<Transport> GetTransport() const { return transport_; }
+
+    // Called after every request with its timing. Without hook, the timing is not even read from curl.
+    // With a thread safe transport, hooks and recorders are called concurrently by the threads sending requests.
+    using TimingHook = std::function<void(const RequestTiming& timing)>;
+    void SetTimingHook(TimingHook hook) { timing_hook_ = hook; }
+
+    // Called after every request answered, with the request and its answer: e.g. to record the traffic
+    using Recorder = std::function<void(const Exchange& exchange)>;
+    void SetRecorder(Recorder recorder) { recorder_ = recorder; }
+
+    // Send a request described by the caller, leaving the url, body and headers set on the session alone:
+    // threads sharing the session send their own requests, in parallel if the transport is thread safe.
+    Response send(const TransportRequest& request);
+
+    // Content type of the body, form encoded by default (Web API methods and incoming webhooks)
+    void SetContentType(const std::string& content_type) { content_type_ = content_type; }
+
+    // e.g. "Bearer xoxb-...", for the methods which do not take the token in their arguments. Empty: no header.
+    void SetAuthorization(const std::string& authorization) { authorization_ = authorization; }
+
+    // The body is not copied: data must outlive the request
+    void SetBody(const std::string& data) { body_ = BufferView{data}; }
     Response Get();
     Response Post();
     Response makeRequest();
     std::string easyEscape(const std::string& text);
 
-private:
-    static size_t writeFunction(void* ptr, size_t size, size_t nmemb, std::string* data) {
-        data->append((char*) ptr, size * nmemb);
-        return size * nmemb;
+    // Delay asked by a 429 response, from its headers
+    static long retryAfter(const std::string& header) {
+        std::string line;
+        std::istringstream stream{header};
+        while (std::getline(stream, line)) {
+            static const std::string name{"retry-after:"};
+            if (line.size() > name.size() && std::equal(name.begin(), name.end(), line.begin(), 
+                    [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+                return std::strtol(line.c_str() + name.size(), nullptr, 10);
+            }
+        }
+        return 0;
     }
 
 private:
-    CURL*       curl_;
-    CURLcode    res_;
+    std::shared_ptr<Transport> transport_;
     std::string url_;
     std::string proxy_url_;
+    bool        accept_encoding_{false};
     std::string token_;
+    std::string content_type_{"application/x-www-form-urlencoded"};
+    std::string authorization_;
+    std::string verb_{"POST"};
+    BufferView  body_;
+    TimingHook  timing_hook_;
+    Recorder    recorder_;
 
     bool        throw_exception_;
     std::mutex  mutex_request_;
 };
 
-inline
-void Session::SetBody(const std::string& data) { 
-        if (curl_) {
-            curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, data.length());
-            curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, data.data());
-        }
-    }
-
 inline
 Response Session::Get() {
-    if (curl_) {
-        curl_easy_setopt(curl_, CURLOPT_HTTPGET, 1L);
-        curl_easy_setopt(curl_, CURLOPT_POST, 0L);
-        curl_easy_setopt(curl_, CURLOPT_NOBODY, 0L);
-    }
+    verb_ = "GET";
     return makeRequest();
 }
 
 inline
 Response Session::Post() {
+    verb_ = "POST";
     return makeRequest();
 }
 
 inline
 Response Session::makeRequest() {
-    std::lock_guard<std::mutex> lock(mutex_request_);
-    
-    //------ set our custom set of headers
-    // for  using incoming webhook it is mandatory to set 
-    // "Content-Type: application/x-www-form-urlencoded" in header
+    return send(TransportRequest{BufferView{verb_}, BufferView{url_}, BufferView{content_type_}, BufferView{authorization_}, body_, BufferView{}});
+}
 
-    curl_header  header(curl_);
-    header.append("Content-Type: application/x-www-form-urlencoded");
-    
-    //-------- set our custom set of headers------------------------------  
+inline
+Response Session::send(const TransportRequest& request) {
+    auto transport = transport_.get();
+    std::unique_lock<std::mutex> lock(mutex_request_, std::defer_lock);
+    if (!transport->thread_safe()) { lock.lock(); }
 
-    curl_easy_setopt(curl_, CURLOPT_URL, url_.c_str());
-    
-    std::string response_string;
-    std::string header_string;
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeFunction);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_string);
-    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &header_string);
+    TransportResult result;
+    bool answered = transport->perform(request, result, timing_hook_ || recorder_);
 
-    res_ = curl_easy_perform(curl_);
+    if (timing_hook_) { timing_hook_(result.timing); } // failed requests too: a slow DNS or connect is what is looked for
+    if (recorder_ && answered) {
+        recorder_(Exchange{request.verb.str(), request.url.str(), request.body.str(), result.status_code, result.headers, result.body, result.timing});
+    }
 
-    bool is_error = false;
-    std::string error_msg{};
-    if(res_ != CURLE_OK) {
-        is_error = true;
-        error_msg = "curl_easy_perform() failed " + std::string{curl_easy_strerror(res_)};
+    if (!answered) {
         if (throw_exception_) 
-            throw std::runtime_error(error_msg);
+            throw std::runtime_error(result.error);
         else 
-            std::cerr << "[slacking] curl_easy_perform() failed " << error_msg << '\n';
+            std::cerr << "[slacking] " << result.error << '\n';
     }
 
-    return { response_string, is_error, error_msg };
+    auto retry_after = result.status_code == 429 ? retryAfter(result.headers) : 0;
+    return { std::move(result.body), !answered, answered ? std::string{} : result.error, result.status_code, retry_after, result.timing };
 }
 
 inline
 std::string Session::easyEscape(const std::string& text) {
-    char *encoded_output = curl_easy_escape(curl_, text.c_str(), static_cast<int>(text.length()));
-    return std::string{encoded_output};
+    char *encoded_output = curl_easy_escape(nullptr, text.c_str(), static_cast<int>(text.length()));
+    std::string escaped{encoded_output ? encoded_output : ""};
+    curl_free(encoded_output);
+    return escaped;
 }
 
 // forward declaration for category structures
@@ -230,7 +807,53 @@ private:
     Slacking& slack_;
 };
 
+// A message to post, as a value: built per call and handed to chat.post() or hook.post(), it shares nothing with
+// the other threads. Every with_ method returns a modified copy:
+//
+//     slack.chat.post(slack.chat.message("Deployed", "#ops").with_username("CI").with_blocks(blocks));
+struct ChatMessage {
+    std::string channel{};
+    std::string text{};
+    std::string username{};
+    std::string icon_url{};
+    std::string icon_emoji{};
+    std::string parse{};
+    std::string thread_ts{};   // reply in this thread
+    Json        attachments{};
+    Json        blocks{};
+
+    ChatMessage() = default;
+    ChatMessage(const std::string& t, const std::string& c) : channel{c}, text{t} {}
+
+    ChatMessage with_channel(const std::string& c) const     { auto message = *this; message.channel = c; return message; }
+    ChatMessage with_username(const std::string& u) const    { auto message = *this; message.username = u; return message; }
+    ChatMessage with_icon_url(const std::string& i) const    { auto message = *this; message.icon_url = i; return message; }
+    ChatMessage with_icon_emoji(const std::string& i) const  { auto message = *this; message.icon_emoji = i; return message; }
+    ChatMessage with_parse(const std::string& p) const       { auto message = *this; message.parse = p; return message; }
+    ChatMessage with_thread_ts(const std::string& ts) const  { auto message = *this; message.thread_ts = ts; return message; }
+    ChatMessage with_attachments(const Json& a) const        { auto message = *this; message.attachments = a; return message; }
+    ChatMessage with_blocks(const Json& b) const             { auto message = *this; message.blocks = b; return message; }
+
+    // The fields which are set, attachments and blocks serialized
+    Json arguments() const {
+        Json json = Json::object();
+        auto set = [&json](const char* key, const std::string& value) { if (!value.empty()) { json[key] = value; } };
+        set("channel", channel);
+        set("text", text);
+        set("username", username);
+        set("icon_url", icon_url);
+        set("icon_emoji", icon_emoji);
+        set("parse", parse);
+        set("thread_ts", thread_ts);
+        if (!attachments.is_null()) { json["attachments"] = attachments.dump(); }
+        if (!blocks.is_null())      { json["blocks"] = blocks.dump(); }
+        return json;
+    }
+};
+
 // Chat category structure for chat related method such as chat.postMessage. Every public data members can be manually filled.
+// They are the defaults of message(): fill them before the instance is shared between threads, then post messages
+// with post(message(...)), which leaves them untouched.
 struct CategoryChat {
     std::string channel{};      // required
     std::string username{};     // optional
@@ -245,8 +868,21 @@ struct CategoryChat {
         channel = c; username = u; icon_emoji = i;
     }
 
+    // Not thread safe when attachments is used: it is reset after each message
     Json postMessage(const std::string& text=" ", const std::string& specified_channel="");
 
+    // A message with the defaults above, to complete then post()
+    ChatMessage message(const std::string& text, const std::string& specified_channel = "") const {
+        auto message = ChatMessage{text, specified_channel.empty() ? channel : specified_channel};
+        message.username   = username;
+        message.icon_url   = icon_url;
+        message.icon_emoji = icon_emoji;
+        message.parse      = parse;
+        return message;
+    }
+
+    Json post(const ChatMessage& message) const;
+
     CategoryChat(Slacking& slack) : slack_{slack} {}
 
 public: // exceptional for escape text (should be review)
@@ -260,12 +896,24 @@ struct CategoryWebHook {
     std::string username{};     // optional
     std::string icon_emoji{};   // optional
     std::string Id{};           // required 
+    std::string base_url{"https://hooks.slack.com/services/"}; // e.g. a local mock server
 
     void channel_username_iconemoji(const std::string& c, const std::string& u, const std::string& i) {
         channel = c; username = u; icon_emoji = i;
     }
 
     Json postMessage(const std::string& text = " ", const std::string& specified_channel = "");
+
+    // A message with the defaults above, to complete then post()
+    ChatMessage message(const std::string& text, const std::string& specified_channel = "") const {
+        auto message = ChatMessage{text, specified_channel.empty() ? channel : specified_channel};
+        message.username   = username;
+        message.icon_emoji = icon_emoji;
+        return message;
+    }
+
+    // Posted to base_url + Id, without touching the base url of the Web API
+    Json post(const ChatMessage& message) const;
     
     CategoryWebHook(Slacking& slack) : slack_{ slack } {}
 
@@ -289,6 +937,52 @@ private:
 
 
 
+// Typed decoding of Web API responses.
+// A response structure declares once the fields it cares about with a list of FieldBinding (see User::fields()).
+// The Decoder fills these structures straight from the SAX events of the parser: no Json DOM is built
+// and every field which is not bound (e.g. the large profile image urls of users.list) is skipped.
+
+template<typename T>
+struct FieldBinding {
+    enum class Kind { String, Bool, Unsigned, UInt64, Double };
+
+    std::string path;   // dotted path relative to the decoded object, e.g. "profile.email"
+    Kind        kind;
+    std::string   T::* string_member;
+    bool          T::* bool_member;
+    unsigned      T::* unsigned_member;
+    std::uint64_t T::* uint64_member;
+    double        T::* double_member;
+
+    FieldBinding(const std::string& p, Kind k) 
+        : path{p}, kind{k}, string_member{nullptr}, bool_member{nullptr}, unsigned_member{nullptr}, uint64_member{nullptr}, double_member{nullptr} {}
+};
+
+template<typename T>
+FieldBinding<T> field(const std::string& path, std::string T::* member) {
+    FieldBinding<T> binding{path, FieldBinding<T>::Kind::String}; binding.string_member = member; return binding;
+}
+
+template<typename T>
+FieldBinding<T> field(const std::string& path, bool T::* member) {
+    FieldBinding<T> binding{path, FieldBinding<T>::Kind::Bool}; binding.bool_member = member; return binding;
+}
+
+template<typename T>
+FieldBinding<T> field(const std::string& path, unsigned T::* member) {
+    FieldBinding<T> binding{path, FieldBinding<T>::Kind::Unsigned}; binding.unsigned_member = member; return binding;
+}
+
+template<typename T>
+FieldBinding<T> field(const std::string& path, std::uint64_t T::* member) {
+    FieldBinding<T> binding{path, FieldBinding<T>::Kind::UInt64}; binding.uint64_member = member; return binding;
+}
+
+template<typename T>
+FieldBinding<T> field(const std::string& path, double T::* member) {
+    FieldBinding<T> binding{path, FieldBinding<T>::Kind::Double}; binding.double_member = member; return binding;
+}
+
 // User convenient structure for users.list
 struct User {
     std::string id;
@@ -296,22 +990,257 @@ struct User {
     std::string email;
     std::string real_name;
     std::string presence;
-    bool is_bot; // someone who left the team is considered as bot? and slackbot is considered as human?
+    bool is_bot{true}; // someone who left the team is considered as bot? and slackbot is considered as human?
 
+    User() = default;
     User(const std::string& i, const std::string& n, const std::string& e, const std::string& r, const std::string& p, bool bot) 
         : id{i}, name{n}, email{e}, real_name{r}, presence{p}, is_bot{bot} {}
+
+    static const std::vector<FieldBinding<User>>& fields() {
+        static const std::vector<FieldBinding<User>> bindings = {
+            field("id", &User::id), field("name", &User::name), field("profile.email", &User::email),
+            field("profile.real_name", &User::real_name), field("presence", &User::presence), field("is_bot", &User::is_bot)
+        };
+        return bindings;
+    }
 };
 
 // Channel convenient structure for conversations.list
 struct Channel {
     std::string id;
     std::string name;
-    unsigned num_members;
+    unsigned num_members{0};
 
+    Channel() = default;
     Channel(const std::string& i, const std::string& n, unsigned num) 
         : id{i}, name{n}, num_members{num} {}
+
+    static const std::vector<FieldBinding<Channel>>& fields() {
+        static const std::vector<FieldBinding<Channel>> bindings = {
+            field("id", &Channel::id), field("name", &Channel::name), field("num_members", &Channel::num_members)
+        };
+        return bindings;
+    }
+};
+
+// Message convenient structure for conversations.history and conversations.replies
+struct Message {
+    std::string type;
+    std::string subtype;
+    std::string user;
+    std::string bot_id;
+    std::string text;
+    std::string ts;
+    std::string thread_ts;
+    unsigned reply_count{0};
+
+    static const std::vector<FieldBinding<Message>>& fields() {
+        static const std::vector<FieldBinding<Message>> bindings = {
+            field("type", &Message::type), field("subtype", &Message::subtype), field("user", &Message::user),
+            field("bot_id", &Message::bot_id), field("text", &Message::text), field("ts", &Message::ts),
+            field("thread_ts", &Message::thread_ts), field("reply_count", &Message::reply_count)
+        };
+        return bindings;
+    }
+};
+
+// File convenient structure for files.list and files.info
+struct File {
+    std::string id;
+    std::string name;
+    std::string title;
+    std::string mimetype;
+    std::string filetype;
+    std::string user;
+    std::string url_private;
+    std::string permalink;
+    std::uint64_t size{0};
+
+    static const std::vector<FieldBinding<File>>& fields() {
+        static const std::vector<FieldBinding<File>> bindings = {
+            field("id", &File::id), field("name", &File::name), field("title", &File::title),
+            field("mimetype", &File::mimetype), field("filetype", &File::filetype), field("user", &File::user),
+            field("url_private", &File::url_private), field("permalink", &File::permalink), field("size", &File::size)
+        };
+        return bindings;
+    }
+};
+
+// Result of a typed decoding: the envelope of the Web API response and the decoded structures.
+template<typename T>
+struct Decoded {
+    bool        has_ok{false};
+    bool        ok{false};
+    std::string error{};
+    std::string next_cursor{};
+    std::vector<T> items{};
+};
+
+// SAX consumer for nlohmann::json::sax_parse which decodes the value found under collection_key.
+// The value can be an array of objects (users.list "members") or a single object (users.info "user").
+template<typename T>
+class Decoder {
+public:
+    using number_integer_t  = Json::number_integer_t;
+    using number_unsigned_t = Json::number_unsigned_t;
+    using number_float_t    = Json::number_float_t;
+    using string_t          = Json::string_t;
+    using binary_t          = Json::binary_t;
+
+    Decoder(Decoded<T>& result, const std::string& collection_key) 
+        : result_(result), collection_key_{collection_key}, bindings_(T::fields()) {
+        for (auto const& binding : bindings_) {
+            for (auto pos = binding.path.find('.'); pos != std::string::npos; pos = binding.path.find('.', pos + 1)) {
+                prefixes_.push_back(binding.path.substr(0, pos));
+            }
+        }
+    }
+
+    bool null() { return value(); }
+    bool boolean(bool val) {
+        if (skip_depth_ > 0) { return true; }
+        if (frames_.size() == 1 && key_ == "ok") { result_.has_ok = true; result_.ok = val; }
+        else if (auto binding = bound()) {
+            if (binding->kind == FieldBinding<T>::Kind::Bool) { result_.items.back().*(binding->bool_member) = val; }
+        }
+        return true;
+    }
+    bool number_integer(number_integer_t val) { return number(static_cast<double>(val), val < 0 ? 0 : static_cast<std::uint64_t>(val)); }
+    bool number_unsigned(number_unsigned_t val) { return number(static_cast<double>(val), val); }
+    bool number_float(number_float_t val, const string_t&) { return number(val, val < 0 ? 0 : static_cast<std::uint64_t>(val)); }
+    bool string(string_t& val) {
+        if (skip_depth_ > 0) { return true; }
+        if (frames_.size() == 1 && key_ == "error") { result_.error = std::move(val); }
+        else if (frames_.size() == 2 && frames_.back() == Frame::Metadata && key_ == "next_cursor") { result_.next_cursor = std::move(val); }
+        else if (auto binding = bound()) {
+            if (binding->kind == FieldBinding<T>::Kind::String) { result_.items.back().*(binding->string_member) = std::move(val); }
+        }
+        return true;
+    }
+    bool binary(binary_t&) { return value(); }
+
+    bool start_object(std::size_t) {
+        if (skip_depth_ > 0) { ++skip_depth_; return true; }
+        if (frames_.empty()) { frames_.push_back(Frame::Root); return true; }
+        switch (frames_.back()) {
+        case Frame::Root:
+            if (key_ == collection_key_) { begin_item(); }
+            else if (key_ == "response_metadata") { frames_.push_back(Frame::Metadata); }
+            else { skip_depth_ = 1; }
+            break;
+        case Frame::Collection:
+            begin_item();
+            break;
+        case Frame::Item:
+        case Frame::Nested: {
+            auto candidate = path_.empty() ? key_ : path_ + '.' + key_;
+            if (std::find(prefixes_.begin(), prefixes_.end(), candidate) != prefixes_.end()) {
+                path_lengths_.push_back(path_.size());
+                path_ = std::move(candidate);
+                frames_.push_back(Frame::Nested);
+            }
+            else { skip_depth_ = 1; }
+            break;
+        }
+        default:
+            skip_depth_ = 1;
+        }
+        return true;
+    }
+
+    bool key(string_t& val) {
+        if (skip_depth_ == 0) { key_ = std::move(val); }
+        return true;
+    }
+
+    bool end_object() {
+        if (skip_depth_ > 0) { --skip_depth_; return true; }
+        if (frames_.back() == Frame::Nested) {
+            path_.resize(path_lengths_.back());
+            path_lengths_.pop_back();
+        }
+        frames_.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (skip_depth_ > 0) { ++skip_depth_; return true; }
+        if (frames_.size() == 1 && key_ == collection_key_) { frames_.push_back(Frame::Collection); }
+        else { skip_depth_ = 1; }
+        return true;
+    }
+
+    bool end_array() {
+        if (skip_depth_ > 0) { --skip_depth_; return true; }
+        frames_.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+        result_.has_ok = true;
+        result_.ok = false;
+        result_.error = ex.what();
+        return false;
+    }
+
+private:
+    enum class Frame { Root, Metadata, Collection, Item, Nested };
+
+    void begin_item() {
+        result_.items.emplace_back();
+        path_.clear();
+        frames_.push_back(Frame::Item);
+    }
+
+    // binding of the scalar value which is being read, nullptr if the value is not wanted
+    const FieldBinding<T>* bound() {
+        if (frames_.empty() || (frames_.back() != Frame::Item && frames_.back() != Frame::Nested)) { return nullptr; }
+        for (auto const& binding : bindings_) {
+            if (path_.empty() ? binding.path == key_ 
+                              : (binding.path.size() == path_.size() + 1 + key_.size() && binding.path.compare(0, path_.size(), path_) == 0 
+                                 && binding.path[path_.size()] == '.' && binding.path.compare(path_.size() + 1, std::string::npos, key_) == 0)) {
+                return &binding;
+            }
+        }
+        return nullptr;
+    }
+
+    bool value() { return true; }
+
+    bool number(double val, std::uint64_t unsigned_val) {
+        if (skip_depth_ > 0) { return true; }
+        if (auto binding = bound()) {
+            auto& item = result_.items.back();
+            switch (binding->kind) {
+            case FieldBinding<T>::Kind::Unsigned: item.*(binding->unsigned_member) = static_cast<unsigned>(unsigned_val); break;
+            case FieldBinding<T>::Kind::UInt64:   item.*(binding->uint64_member) = unsigned_val; break;
+            case FieldBinding<T>::Kind::Double:   item.*(binding->double_member) = val; break;
+            default: break;
+            }
+        }
+        return true;
+    }
+
+    Decoded<T>&                         result_;
+    std::string                         collection_key_;
+    const std::vector<FieldBinding<T>>& bindings_;
+    std::vector<std::string>            prefixes_;
+    std::vector<Frame>                  frames_;
+    std::vector<std::size_t>            path_lengths_;
+    std::string                         path_;
+    std::string                         key_;
+    unsigned                            skip_depth_{0};
 };
 
+// Decode a Web API response text into typed structures
+template<typename T>
+Decoded<T> decode(const std::string& text, const std::string& collection_key) {
+    Decoded<T> result;
+    Decoder<T> decoder{result, collection_key};
+    Json::sax_parse(text, &decoder);
+    return result;
+}
+
 
 // Basic element types.
 struct Element {
@@ -324,6 +1253,8 @@ struct Element {
 std::ostream& operator<<(std::ostream &os, const Element& element);
 std::ostream& operator<<(std::ostream &os, const User& user);
 std::ostream& operator<<(std::ostream &os, const Channel& channel);
+std::ostream& operator<<(std::ostream &os, const Message& message);
+std::ostream& operator<<(std::ostream &os, const File& file);
 
 template<typename T>
 std::ostream& operator<<(std::ostream &os, const std::vector<T>& vec);
@@ -340,6 +1271,60 @@ std::string join(const std::vector<T>& vec, const std::string& sep = "&");
 void replace_all(std::string& str, const std::string& from, const std::string& to);
 
 
+// Observer of the Web API calls made by a Slacking instance, e.g. slack::Metrics (see metrics.hpp).
+// It is called from the threads making the calls.
+class CallObserver {
+public:
+    virtual ~CallObserver() = default;
+    virtual void started(const std::string& method) = 0;
+    // error is empty on success, else the Slack error code ("channel_not_found"), "ratelimited", "http_error" when
+    // no answer was received or "http_" and the status code of an answer other than 2xx ("http_503")
+    virtual void finished(const std::string& method, std::chrono::steady_clock::duration latency, long status_code, const std::string& error) = 0;
+};
+
+// Report a call to the observer when going out of scope, also when the call throws
+class ObservedCall {
+public:
+    ObservedCall(CallObserver* observer, const std::string& method) : observer_{observer}, method_(method) {
+        if (observer_) { start_ = std::chrono::steady_clock::now(); observer_->started(method_); }
+    }
+    ~ObservedCall() {
+        if (observer_) { observer_->finished(method_, std::chrono::steady_clock::now() - start_, status_code_, error_); }
+    }
+
+    ObservedCall(const ObservedCall&)            = delete;
+    ObservedCall& operator=(const ObservedCall&) = delete;
+
+    void response(const Response& response) {
+        if (!observer_) { return; }
+        status_code_ = response.status_code;
+        if (response.is_error)                 { error_ = "http_error"; }
+        else if (response.status_code == 429)  { error_ = "ratelimited"; }
+        else if (response.status_code < 200 || response.status_code >= 300) { error_ = "http_" + std::to_string(response.status_code); }
+        else                                   { error_.clear(); }
+    }
+
+    void result(bool has_ok, bool ok, const std::string& error) {
+        if (observer_ && error_.empty() && has_ok && !ok) { error_ = error.empty() ? "unknown_error" : error; }
+    }
+
+    void result(const Json& json) {
+        if (!observer_ || !json.is_object()) { return; }
+        auto ok = json.find("ok");
+        auto error = json.find("error");
+        result(ok != json.end() && ok->is_boolean(), ok != json.end() && ok->is_boolean() && ok->get<bool>(),
+               error != json.end() && error->is_string() ? error->get<std::string>() : "");
+    }
+
+private:
+    CallObserver*      observer_;
+    const std::string& method_;
+    std::chrono::steady_clock::time_point start_{};
+    long               status_code_{0};
+    std::string        error_{"http_error"}; // until a response is received: the session may throw before
+};
+
+
 class Slacking {
 public:
     Slacking() = delete;
@@ -349,13 +1334,41 @@ public:
         session_.SetUrl("https://slack.com/api/");
         session_.SetToken(token_);
     }
+
+    // Send the requests through transport from the start, e.g. one shared by many instances (see client_pool.hpp)
+    Slacking(const std::string& token, bool throw_exception, std::shared_ptr<Transport> transport)
+    : session_{throw_exception, transport}, token_{token}, throw_exception_{throw_exception}
+    {
+        session_.SetUrl("https://slack.com/api/");
+        session_.SetToken(token_);
+    }
      
 
+    ~Slacking() { clearEndpoints(); }
+
     Slacking(const Slacking&)            = delete;
     Slacking& operator=(const Slacking&) = delete;
 
     void set_proxy(const std::string& url) { session_.SetProxyUrl(url); }
 
+    // Receive the network timing (DNS, connect, TLS, server, transfer) of every request
+    void set_timing_hook(Session::TimingHook hook) { session_.SetTimingHook(hook); }
+
+    // Record every request and its answer, e.g. to a trace file (see trace.hpp)
+    void set_recorder(Session::Recorder recorder) { session_.SetRecorder(recorder); }
+
+    // Send the requests through another transport than libcurl, e.g. in tests. With a thread safe transport such
+    // as PooledCurlTransport, the threads sharing this instance send their calls in parallel.
+    void set_transport(std::shared_ptr<Transport> transport) { session_.SetTransport(transport); }
+    std::shared_ptr<Transport> transport() const { return session_.GetTransport(); }
+
+    // Ask Slack for compressed answers: less bandwidth for the big pages of users.list or conversations.history,
+    // for the CPU of decompressing them. Off by default; see also compression.hpp for the requests.
+    void set_accept_encoding(bool accept = true) { session_.SetAcceptEncoding(accept); }
+
+    // Report every call of post(), get() and post_decoded(), thus of every category method. Set it before calling.
+    void set_observer(std::shared_ptr<CallObserver> observer) { observer_ = observer; }
+
 
     void change_token(const std::string& token) { token_ = token; };
     void set_throw_exception(bool throw_exception) { throw_exception_ = throw_exception; }
@@ -368,43 +1381,11 @@ public:
     }
 
     Json post(const std::string& method, const std::string& data = "") {
-        setParameters(method, data);
-        auto response = session_.Post();
-        if (response.is_error){ 
-            trigger_error(response.error_message);
-        }
-
-        Json json{};
-        if (isJson(response.text)){
-
-            json = Json::parse(response.text); 
-            checkResponse(method, json);
-        }
-        else{
-          #if SLACKING_VERBOSE_OUTPUT
-            std::cout << "<< " << response.text << "\n";
-          #endif
-        }
-       
-        return json;
+        return request(method, base_url + method, data, HttpVerb::Post);
     }
 
     Json get(const std::string& method, const std::string& data = "") {
-        setParameters(method, data);
-        auto response = session_.Get();
-        if (response.is_error) { trigger_error(response.error_message); }
-
-        Json json{};
-        if (isJson(response.text)) {
-            json = Json::parse(response.text);
-            checkResponse(method, json);
-        }
-        else{
-          #if SLACKING_VERBOSE_OUTPUT
-            std::cout << "<< " << response.text<< "\n";
-          #endif
-        }
-        return json;
+        return request(method, base_url + method, data, HttpVerb::Get);
     }
 
     Json post(const std::string& method, const Json& json) {
@@ -420,12 +1401,69 @@ public:
         return get(method, join(elements));
     }
 
+    // Typed variant of post: the response is decoded without DOM into the structures found under collection_key
+    template<typename T>
+    Decoded<T> post_decoded(const std::string& method, const std::string& collection_key, const Json& json) {
+        auto data = formEncode(json); // curl does not copy the body, it must outlive the request
+        data += (data.empty() ? "token=" : "&token=") + easyEscape(token_);
+        ObservedCall call{observer_.get(), method};
+        auto response = send(base_url + method, data, HttpVerb::Post, formContentType(), "");
+        call.response(response);
+        if (response.is_error) { trigger_error(response.error_message); }
+        checkRateLimit(method, response);
+
+        auto decoded = decode<T>(response.text, collection_key);
+        call.result(decoded.has_ok, decoded.ok, decoded.error);
+        if (decoded.has_ok && !decoded.ok) {
+            trigger_error('"' + decoded.error + '"');
+        }
+#if SLACKING_VERBOSE_OUTPUT
+        else { std::cout << "<< " << method << " [passed]\n"; }
+#endif
+        return decoded;
+    }
+
+    // Call a method of the catalog (methods.hpp), e.g. call(slack::methods::chat_postMessage, {{"channel", id}, {"text", text}}).
+    // The required arguments are checked before sending, the call waits for the rate limiter if one is set
+    // and goes to an url built once per base url. Unlike post(), the arguments are escaped here and the token
+    // is sent in the Authorization header: GET methods take their arguments in the query string.
+    Json call(const MethodDescriptor& method, const Json& arguments = Json::object()) {
+        Endpoint uncached;
+        auto const& endpoint = endpointOf(method, uncached);
+        for (std::size_t i = 0; i < method.required_count; ++i) {
+            if (!arguments.is_object() || !arguments.count(method.required[i])) {
+                trigger_error("missing argument " + std::string{method.required[i]} + " of " + endpoint.name);
+                return Json{};
+            }
+        }
+        if (limiter_) { limiter_->acquire(endpoint.name, method.tier); }
+
+        auto authorization = "Bearer " + token_;
+        if (method.encoding == ArgumentEncoding::Json && method.verb == HttpVerb::Post) {
+            static const std::string json_content_type{"application/json; charset=utf-8"};
+            return request(endpoint.name, endpoint.url, arguments.is_object() ? arguments.dump() : "{}", HttpVerb::Post,
+                           json_content_type, authorization);
+        }
+        auto data = formEncode(arguments);
+        if (method.verb == HttpVerb::Get) {
+            return request(endpoint.name, data.empty() ? endpoint.url : endpoint.url + '?' + data, "", HttpVerb::Get,
+                           formContentType(), authorization);
+        }
+        return request(endpoint.name, endpoint.url, data, HttpVerb::Post, formContentType(), authorization);
+    }
+
+    // Pace call() with the tier of each method, and hold a method for the delay asked when Slack answers 429.
+    // The limiter may be shared by the Slacking instances using the same token.
+    void set_rate_limiter(RateLimiter& limiter) { limiter_ = &limiter; }
+
     std::string easyEscape(const std::string& text) { return session_.easyEscape(text); }
 
     void debug() const { std::cout << token_ << '\n'; }
 
+    // Like the other settings, before the instance is shared between threads
     void setBaseUrl(const std::string &url) {
         base_url = url;
+        clearEndpoints();
     }
 
     std::string getBaseUrl() const {
@@ -434,15 +1472,95 @@ public:
 private:
     std::string base_url{ "https://slack.com/api/" };
 
-    void setParameters(const std::string& method, const std::string& data = "") {
-        auto complete_url =  base_url+ method;
-        session_.SetUrl(complete_url);
-        session_.SetBody(data);
+    friend struct CategoryChat;
+    friend struct CategoryWebHook;
+
+    static const std::string& formContentType() {
+        static const std::string content_type{"application/x-www-form-urlencoded"};
+        return content_type;
+    }
+
+    // Urls and names of the methods of the catalog called so far, by index of their descriptor. An endpoint never
+    // changes once published, so concurrent calls read them without lock; two threads racing to build the same
+    // one keep the first.
+    struct Endpoint {
+        std::string name;
+        std::string url;
+    };
+    static const std::size_t cached_endpoints = 256; // descriptors of higher index build their url at each call
+    std::unique_ptr<std::atomic<Endpoint*>[]> endpoints_{new std::atomic<Endpoint*>[cached_endpoints]()};
+
+    const Endpoint& endpointOf(const MethodDescriptor& method, Endpoint& uncached) {
+        if (method.index >= cached_endpoints) {
+            uncached = Endpoint{method.name, base_url + method.name};
+            return uncached;
+        }
+        auto& slot = endpoints_[method.index];
+        auto endpoint = slot.load(std::memory_order_acquire);
+        if (endpoint) { return *endpoint; }
+        std::unique_ptr<Endpoint> built{new Endpoint{method.name, base_url + method.name}};
+        if (slot.compare_exchange_strong(endpoint, built.get(), std::memory_order_acq_rel)) { return *built.release(); }
+        return *endpoint; // built by another thread meanwhile
+    }
+
+    void clearEndpoints() {
+        for (std::size_t i = 0; i < cached_endpoints; ++i) { delete endpoints_[i].exchange(nullptr); }
+    }
+
+    std::string formEncode(const Json& arguments) {
+        std::string data;
+        if (!arguments.is_object()) { return data; }
+        for (auto it = arguments.begin(); it != arguments.end(); ++it) {
+            if (!data.empty()) { data += '&'; }
+            data += it.key();
+            data += '=';
+            data += easyEscape(it->is_string() ? it->get<std::string>() : it->dump());
+        }
+        return data;
+    }
+
+    // Every call goes through here with its own url, body and headers: nothing of the instance is written,
+    // so threads may share it
+    Json request(const std::string& method, const std::string& url, const std::string& data, HttpVerb verb,
+                 const std::string& content_type = formContentType(), const std::string& authorization = "") {
+        ObservedCall call{observer_.get(), method};
+        auto response = send(url, data, verb, content_type, authorization);
+        call.response(response);
+        if (response.is_error){ 
+            trigger_error(response.error_message);
+        }
+        checkRateLimit(method, response);
+
+        auto json = Json::parse(response.text, nullptr, false); // single parse, discarded if not json
+        if (!json.is_discarded()){
+            call.result(json);
+            checkResponse(method, json);
+        }
+        else{
+            json = Json{};
+          #if SLACKING_VERBOSE_OUTPUT
+            std::cout << "<< " << response.text << "\n";
+          #endif
+        }
+        return json;
+    }
 
+    Response send(const std::string& url, const std::string& data, HttpVerb verb,
+                  const std::string& content_type, const std::string& authorization) {
 #if SLACKING_VERBOSE_OUTPUT
-        std::cout << ">> sending: "<< complete_url << "  " << data << '\n';
+        std::cout << ">> sending: "<< url << "  " << data << '\n';
 #endif
+        auto verb_view = verb == HttpVerb::Get ? BufferView{"GET", 3} : BufferView{"POST", 4};
+        return session_.send(TransportRequest{verb_view, BufferView{url}, BufferView{content_type}, BufferView{authorization}, BufferView{data}, BufferView{}});
+    }
 
+    // the "ratelimited" error would also be reported by checkResponse but without the delay to respect
+    void checkRateLimit(const std::string& method, const Response& response) {
+        if (response.status_code != 429) { return; }
+        if (limiter_) { limiter_->penalize(method, std::max(1l, response.retry_after)); }
+        if (throw_exception_) {
+            throw RateLimited{response.retry_after};
+        }
     }
 
     void checkResponse(const std::string& method, const Json& json) {
@@ -468,19 +1586,10 @@ private:
         }
     }
 
-    // as of now the only way
-    bool isJson(const std::string &data){
-        bool rc = true;
-        try {
-            auto json = Json::parse(data); // throws if no json 
-        }
-        catch (std::exception &){
-            rc = false;
-        }
-        return(rc);
-    }
 private:
     Session    session_;
+    std::shared_ptr<CallObserver> observer_;
+    RateLimiter* limiter_{nullptr};
 
 public:
     std::string             token_;
@@ -536,6 +1645,38 @@ void replace_all(std::string& str, const std::string& from, const std::string& t
     }
 }
 
+// Decode an application/x-www-form-urlencoded body
+inline
+std::map<std::string, std::string> parse_form(const std::string& body) {
+    auto unescape = [](const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '+') { out += ' '; }
+            else if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1]))
+                                                         && std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+                out += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+            }
+            else { out += text[i]; }
+        }
+        return out;
+    };
+    std::map<std::string, std::string> fields;
+    std::size_t begin = 0;
+    while (begin <= body.size()) {
+        auto end = body.find('&', begin);
+        if (end == std::string::npos) { end = body.size(); }
+        auto pair = body.substr(begin, end - begin);
+        auto equal = pair.find('=');
+        if (!pair.empty()) {
+            fields[unescape(pair.substr(0, equal))] = equal == std::string::npos ? "" : unescape(pair.substr(equal + 1));
+        }
+        begin = end + 1;
+    }
+    return fields;
+}
+
 inline
 std::string bool_to_string(const bool b) {
     std::ostringstream ss;
@@ -559,6 +1700,16 @@ std::ostream& operator<<(std::ostream &os, const Channel& channel) {
     return os << "{ " << join(std::vector<std::string>{channel.id, channel.name, std::to_string(channel.num_members)}, ", ") << " }";
 }
 
+inline
+std::ostream& operator<<(std::ostream &os, const Message& message) {
+    return os << "{ " << join(std::vector<std::string>{message.ts, message.user, message.text}, ", ") << " }";
+}
+
+inline
+std::ostream& operator<<(std::ostream &os, const File& file) {
+    return os << "{ " << join(std::vector<std::string>{file.id, file.name, file.mimetype, std::to_string(file.size)}, ", ") << " }";
+}
+
 // pretty printer for magic output
 template<typename T>
 inline
@@ -634,12 +1785,15 @@ Json CategoryConversations::list(bool exclude_archived) {
 
 inline
 auto CategoryConversations::list_magic(bool exclude_archived) -> std::vector<Channel> {
-    auto json_channels = list(exclude_archived);
     auto channels = std::vector<Channel>{};
-    channels.reserve(json_channels.size());
-    for (auto channel : json_channels) {
-        channels.emplace_back(channel["id"].get<std::string>(), channel["name"].get<std::string>(), channel["num_members"].get<int>());
-    }
+    std::string cursor{};
+    do {
+        Json arguments = {{"exclude_archived", exclude_archived}};
+        if (!cursor.empty()) { arguments["cursor"] = cursor; }
+        auto page = slack_.post_decoded<Channel>("conversations.list", "channels", arguments);
+        std::move(page.items.begin(), page.items.end(), std::back_inserter(channels));
+        cursor = std::move(page.next_cursor);
+    } while (!cursor.empty());
     return channels;
 }
 
@@ -651,42 +1805,32 @@ Json CategoryConversations::info(const std::string& channel_id) {
 
 inline
 Json CategoryChat::postMessage(const std::string& text, const std::string& specified_channel) {
-    auto str_channel = specified_channel.empty() ? channel : specified_channel;
-    if (str_channel.empty()) { throw std::runtime_error("channel is not set"); }
-    auto escaped_text = slack_.easyEscape(text);
-    Json json_arguments = {
-        { "text"       , escaped_text   }, 
-        { "channel"    , str_channel    }, 
-        { "username"   , username       },
-        { "icon_emoji" , icon_emoji     },
-        { "parse"      , parse          },
-        { "attachments", attachments    }
-        // { "as_user"    , bool_to_string(as_user) } // DEPRECATED!
-    };
-    auto json = slack_.post("chat.postMessage", json_arguments);
-    attachments = Json{};
+    auto json = post(message(text, specified_channel).with_attachments(attachments));
+    if (!attachments.is_null()) { attachments = Json{}; }
     return json;
 }
 
-inline Json CategoryWebHook::postMessage(const std::string& text,
-                                         const std::string& specified_channel) {
-    auto str_channel = specified_channel.empty() ? channel : specified_channel;
-    auto str_emoji = icon_emoji.empty()? "" : icon_emoji;
-
-    Json json_arguments = {{"text", text}, {"channel", str_channel},{ "icon_emoji" , str_emoji} };
+inline
+Json CategoryChat::post(const ChatMessage& message) const {
+    if (message.channel.empty()) { throw std::runtime_error("channel is not set"); }
+    auto data = slack_.formEncode(message.arguments()) + "&token=" + slack_.easyEscape(slack_.token_);
+    return slack_.request("chat.postMessage", slack_.base_url + "chat.postMessage", data, HttpVerb::Post);
+}
 
-    // in this case we did not use  Slack web api
-    std::string baseUrl = slack_.getBaseUrl();
-    slack_.setBaseUrl("https://hooks.slack.com/services/");
+inline
+Json CategoryWebHook::postMessage(const std::string& text, const std::string& specified_channel) {
+    return post(message(text, specified_channel));
+}
 
+inline
+Json CategoryWebHook::post(const ChatMessage& message) const {
     //  webhooks are used with "Content-Type: application/x-www-form-urlencoded" style
     //  this needs  an escaped payload tag  in  the body
-    std::string hookPayload =  "payload=" + slack_.easyEscape(json_arguments.dump());    
-
-    auto  json = slack_.post(Id, hookPayload);
-
-    slack_.setBaseUrl(baseUrl);
-    return json;
+    auto arguments = message.arguments();
+    if (!message.attachments.is_null()) { arguments["attachments"] = message.attachments; } // nested in the payload
+    if (!message.blocks.is_null())      { arguments["blocks"] = message.blocks; }
+    auto payload = "payload=" + slack_.easyEscape(arguments.dump());
+    return slack_.request("webhook", base_url + Id, payload, HttpVerb::Post);
 }
 
 inline
@@ -698,18 +1842,15 @@ Json CategoryUsers::list(bool presence) {
 
 inline
 auto CategoryUsers::list_magic(bool presence) -> std::vector<User> {
-    auto json_members = list(presence);
     auto users = std::vector<User>{};
-    users.reserve(json_members.size());
-    for (auto member : json_members) {
-        auto presence_json = member.count("presence") ? member["presence"] : "";
-        auto email = member["profile"].count("email") ? member["profile"]["email"].dump() : ""; // dump here because email can be null
-        bool is_bot = true;
-        if (member["is_bot"].is_boolean()) { 
-            is_bot = member["is_bot"].get<bool>(); 
-        }
-        users.emplace_back(member["id"].get<std::string>(), member["name"].get<std::string>(), email, member["profile"]["real_name"].get<std::string>(), presence_json.get<std::string>(), is_bot);
-    }
+    std::string cursor{};
+    do {
+        Json arguments = {{"presence", presence ? "1" : "0"}};
+        if (!cursor.empty()) { arguments["cursor"] = cursor; }
+        auto page = slack_.post_decoded<User>("users.list", "members", arguments); // profile images and such are skipped
+        std::move(page.items.begin(), page.items.end(), std::back_inserter(users));
+        cursor = std::move(page.next_cursor);
+    } while (!cursor.empty());
     return users;
 }
 
@@ -725,6 +1866,7 @@ Json CategoryUsers::info(const std::string& user_id) {
 // Public interface
 using _detail::operator<<;
 using _detail::Slacking;
+using _detail::ChatMessage;
 
 // Meyers' singleton
 using _detail::create;
@@ -742,6 +1884,40 @@ using _detail::chat;
 using _detail::users;
 
 using _detail::Json;
+using _detail::parse_form;
+using _detail::RequestTiming;
+using _detail::Exchange;
+
+// Transports
+using _detail::BufferView;
+using _detail::TransportRequest;
+using _detail::TransportResult;
+using _detail::Transport;
+using _detail::CurlShare;
+using _detail::CurlTransport;
+using _detail::PooledCurlTransport;
+
+// Rate limits
+using _detail::RateLimited;
+using _detail::RateTier;
+using _detail::RateLimiter;
+
+// Descriptors of the Web API methods (catalog in methods.hpp)
+using _detail::HttpVerb;
+using _detail::ArgumentEncoding;
+using _detail::MethodDescriptor;
+
+// Observation of the calls
+using _detail::CallObserver;
+
+// Typed decoding
+using _detail::User;
+using _detail::Channel;
+using _detail::Message;
+using _detail::File;
+using _detail::Decoded;
+using _detail::field;
+using _detail::decode;
 
 } // namespace slack
 
@@ -0,0 +1,515 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: Socket Mode client (https://api.slack.com/apis/connections/socket).
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_SOCKET_MODE_HPP_
+#define SLACKING_SOCKET_MODE_HPP_
+
+#include "slacking.hpp"
+#include "dedup.hpp"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <random>
+
+#if defined(_WIN32)
+# include <winsock2.h>
+#else
+# include <sys/select.h>
+#endif
+
+namespace slack {
+
+namespace _detail {
+
+// Minimal RFC 6455 client over a connection opened by curl with CURLOPT_CONNECT_ONLY, so that TLS and
+// proxies are handled by curl and no WebSocket support is required from it. Not thread safe: one thread
+// reads and writes.
+class WebSocket {
+public:
+    enum class Status { Message, Timeout, Closed };
+
+    explicit WebSocket(const std::string& url, const std::string& proxy_url = "") : random_{std::random_device{}()} {
+        auto scheme_end = url.find("://");
+        if (scheme_end == std::string::npos) { throw std::runtime_error("[slacking] invalid websocket url " + url); }
+        auto scheme = url.substr(0, scheme_end);
+        auto rest   = url.substr(scheme_end + 3);
+        auto slash  = rest.find('/');
+        host_ = rest.substr(0, slash);
+        path_ = slash == std::string::npos ? "/" : rest.substr(slash);
+
+        curl_ = curl_easy_init();
+        curl_easy_setopt(curl_, CURLOPT_URL, ((scheme == "wss" ? "https://" : "http://") + host_ + path_).c_str());
+        curl_easy_setopt(curl_, CURLOPT_CONNECT_ONLY, 1L);
+        if (!proxy_url.empty()) { curl_easy_setopt(curl_, CURLOPT_PROXY, proxy_url.c_str()); }
+        auto res = curl_easy_perform(curl_);
+        if (res != CURLE_OK) {
+            curl_easy_cleanup(curl_);
+            throw std::runtime_error("[slacking] websocket connection failed " + std::string{curl_easy_strerror(res)});
+        }
+        curl_easy_getinfo(curl_, CURLINFO_ACTIVESOCKET, &socket_);
+        try { handshake(); }
+        catch (...) {
+            curl_easy_cleanup(curl_); // the destructor does not run for an unfinished constructor
+            throw;
+        }
+    }
+
+    ~WebSocket() { curl_easy_cleanup(curl_); }
+
+    WebSocket(const WebSocket&)            = delete;
+    WebSocket& operator=(const WebSocket&) = delete;
+
+    void send_text(const std::string& text) { sendFrame(0x1, text); }
+    void send_ping() { sendFrame(0x9, ""); }
+    void send_close() {
+        if (!close_sent_) { close_sent_ = true; sendFrame(0x8, std::string{"\x03\xe8", 2}); } // 1000 normal closure
+    }
+
+    // Wait up to timeout for a complete text or binary message. Pings are answered on the fly.
+    Status receive(std::string& message, std::chrono::milliseconds timeout);
+
+    std::chrono::steady_clock::time_point last_received() const { return last_received_; }
+
+private:
+    void handshake();
+    void sendFrame(unsigned char opcode, const std::string& payload);
+    void sendAll(const char* data, std::size_t size);
+    bool waitSocket(bool for_write, std::chrono::milliseconds timeout);
+    bool readAvailable(std::chrono::milliseconds timeout); // false if the connection is closed
+    bool nextFrame(unsigned char& opcode, bool& fin, std::string& payload);
+
+    static std::string base64(const unsigned char* data, std::size_t size) {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (std::size_t i = 0; i < size; i += 3) {
+            std::uint32_t n = std::uint32_t(data[i]) << 16 | (i + 1 < size ? std::uint32_t(data[i + 1]) << 8 : 0) | (i + 2 < size ? data[i + 2] : 0);
+            out += table[(n >> 18) & 63];
+            out += table[(n >> 12) & 63];
+            out += i + 1 < size ? table[(n >> 6) & 63] : '=';
+            out += i + 2 < size ? table[n & 63] : '=';
+        }
+        return out;
+    }
+
+    CURL*          curl_{nullptr};
+    curl_socket_t  socket_{CURL_SOCKET_BAD};
+    std::string    host_;
+    std::string    path_;
+    std::string    buffer_;     // received bytes not parsed yet
+    std::string    fragments_;  // payload of a fragmented message
+    std::mt19937   random_;
+    bool           close_sent_{false};
+    std::chrono::steady_clock::time_point last_received_{std::chrono::steady_clock::now()};
+};
+
+inline
+void WebSocket::handshake() {
+    unsigned char nonce[16];
+    for (auto& byte : nonce) { byte = static_cast<unsigned char>(random_()); }
+    std::string request = "GET " + path_ + " HTTP/1.1\r\n"
+        "Host: " + host_ + "\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: " + base64(nonce, sizeof(nonce)) + "\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    sendAll(request.data(), request.size());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    std::size_t header_end;
+    while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos) {
+        if (std::chrono::steady_clock::now() > deadline || !readAvailable(std::chrono::milliseconds{500})) {
+            throw std::runtime_error("[slacking] websocket handshake failed");
+        }
+    }
+    auto status_line = buffer_.substr(0, buffer_.find("\r\n"));
+    if (status_line.find(" 101") == std::string::npos) {
+        throw std::runtime_error("[slacking] websocket upgrade refused: " + status_line);
+    }
+    buffer_.erase(0, header_end + 4);
+}
+
+inline
+void WebSocket::sendFrame(unsigned char opcode, const std::string& payload) {
+    std::string frame;
+    frame += static_cast<char>(0x80 | opcode);
+    auto size = payload.size();
+    if (size < 126) {
+        frame += static_cast<char>(0x80 | size);
+    }
+    else if (size <= 0xffff) {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>(size >> 8);
+        frame += static_cast<char>(size & 0xff);
+    }
+    else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int i = 7; i >= 0; --i) { frame += static_cast<char>((static_cast<std::uint64_t>(size) >> (8 * i)) & 0xff); }
+    }
+    // frames sent by a client are always masked
+    unsigned char mask[4];
+    for (auto& byte : mask) { byte = static_cast<unsigned char>(random_()); }
+    frame.append(reinterpret_cast<char*>(mask), 4);
+    auto offset = frame.size();
+    frame += payload;
+    for (std::size_t i = 0; i < size; ++i) { frame[offset + i] = static_cast<char>(frame[offset + i] ^ mask[i & 3]); }
+    sendAll(frame.data(), frame.size());
+}
+
+inline
+void WebSocket::sendAll(const char* data, std::size_t size) {
+    while (size > 0) {
+        std::size_t sent = 0;
+        auto res = curl_easy_send(curl_, data, size, &sent);
+        if (res == CURLE_AGAIN) {
+            if (!waitSocket(true, std::chrono::seconds{10})) { throw std::runtime_error("[slacking] websocket send timed out"); }
+            continue;
+        }
+        if (res != CURLE_OK) { throw std::runtime_error("[slacking] websocket send failed " + std::string{curl_easy_strerror(res)}); }
+        data += sent;
+        size -= sent;
+    }
+}
+
+inline
+bool WebSocket::waitSocket(bool for_write, std::chrono::milliseconds timeout) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(socket_, &fds);
+    timeval tv;
+    tv.tv_sec  = static_cast<long>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<long>((timeout.count() % 1000) * 1000);
+    return ::select(static_cast<int>(socket_ + 1), for_write ? nullptr : &fds, for_write ? &fds : nullptr, nullptr, &tv) > 0;
+}
+
+inline
+bool WebSocket::readAvailable(std::chrono::milliseconds timeout) {
+    char chunk[16384];
+    for (bool waited = false; ; ) {
+        std::size_t received = 0;
+        auto res = curl_easy_recv(curl_, chunk, sizeof(chunk), &received);
+        if (res == CURLE_OK) {
+            if (received == 0) { return false; }
+            buffer_.append(chunk, received);
+            last_received_ = std::chrono::steady_clock::now();
+            return true;
+        }
+        if (res != CURLE_AGAIN) { return false; }
+        // data buffered by the TLS layer is returned without waiting, the socket is only polled when empty
+        if (waited || !waitSocket(false, timeout)) { return true; }
+        waited = true;
+    }
+}
+
+// Extract one frame from the buffer, false if it is not complete yet
+inline
+bool WebSocket::nextFrame(unsigned char& opcode, bool& fin, std::string& payload) {
+    if (buffer_.size() < 2) { return false; }
+    auto b0 = static_cast<unsigned char>(buffer_[0]), b1 = static_cast<unsigned char>(buffer_[1]);
+    std::uint64_t size = b1 & 0x7f;
+    std::size_t header = 2;
+    if (size == 126 || size == 127) {
+        std::size_t extra = size == 126 ? 2 : 8;
+        if (buffer_.size() < header + extra) { return false; }
+        size = 0;
+        for (std::size_t i = 0; i < extra; ++i) { size = size << 8 | static_cast<unsigned char>(buffer_[header + i]); }
+        header += extra;
+    }
+    bool masked = (b1 & 0x80) != 0;
+    if (masked) { header += 4; }
+    if (buffer_.size() < header + size) { return false; }
+
+    fin    = (b0 & 0x80) != 0;
+    opcode = b0 & 0x0f;
+    payload.assign(buffer_, header, static_cast<std::size_t>(size));
+    if (masked) {
+        for (std::size_t i = 0; i < payload.size(); ++i) { payload[i] = static_cast<char>(payload[i] ^ buffer_[header - 4 + (i & 3)]); }
+    }
+    buffer_.erase(0, header + static_cast<std::size_t>(size));
+    return true;
+}
+
+inline
+WebSocket::Status WebSocket::receive(std::string& message, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        unsigned char opcode;
+        bool fin;
+        std::string payload;
+        while (nextFrame(opcode, fin, payload)) {
+            switch (opcode) {
+            case 0x0: // continuation
+            case 0x1: // text
+            case 0x2: // binary
+                fragments_ += payload;
+                if (fin) { message.swap(fragments_); fragments_.clear(); return Status::Message; }
+                break;
+            case 0x8: // close
+                send_close();
+                return Status::Closed;
+            case 0x9: // ping
+                sendFrame(0xA, payload);
+                break;
+            default: // pong
+                break;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) { return Status::Timeout; }
+        if (!readAvailable(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now))) { return Status::Closed; }
+    }
+}
+
+struct SocketModeOptions {
+    std::string base_url{};                     // empty: the default Slack Web API url, for apps.connections.open
+    std::string proxy_url{};
+    unsigned    workers{4};                     // threads running the handlers
+    std::size_t queue_capacity{1024};           // envelopes waiting for a worker, above it they are not acked and Slack retries
+    std::chrono::seconds ping_interval{30};     // ping when nothing was received for this long, reconnect after twice as long
+    std::chrono::seconds refresh_margin{60};    // reconnect this long before the approximate connection time announced by hello
+    std::chrono::seconds max_backoff{30};
+};
+
+// Socket Mode client: receives events, slash commands and interactions through a WebSocket opened with
+// apps.connections.open (app-level token "xapp-..."). Every envelope is acked from the read thread as soon
+// as it is queued to the worker pool, before any handler code may delay it. A new connection is opened ahead
+// of the disconnections announced by Slack ("warning", "refresh_requested") or expected from the hello message,
+// and the old one keeps reading until the new one is up: no event is lost while switching.
+class SocketModeClient {
+public:
+    using Handler = std::function<void(const std::string& type, const Json& envelope)>;
+
+    explicit SocketModeClient(const std::string& app_token, SocketModeOptions options = SocketModeOptions{})
+        : app_token_{app_token}, options_(options) {}
+
+    ~SocketModeClient() { stop(); }
+
+    SocketModeClient(const SocketModeClient&)            = delete;
+    SocketModeClient& operator=(const SocketModeClient&) = delete;
+
+    // Handler of every envelope ("events_api", "slash_commands", "interactive"), run by the worker pool. Set it before start().
+    void on_envelope(Handler handler) { handler_ = handler; }
+
+    // Acknowledge without handling the envelopes already handled, e.g. an event retried by Slack
+    void set_deduplicator(std::shared_ptr<Deduplicator> deduplicator) { deduplicator_ = deduplicator; }
+
+    // Handler of the Events API payloads only
+    void on_event(std::function<void(const Json& payload)> handler) {
+        on_envelope([handler](const std::string& type, const Json& envelope) {
+            if (type == "events_api") { handler(envelope["payload"]); }
+        });
+    }
+
+    void start();
+    void stop();
+
+    // Number of envelopes acked so far
+    std::uint64_t acked() const { return acked_; }
+
+private:
+    struct Connection {
+        std::unique_ptr<WebSocket> socket;
+        std::thread                thread;
+        std::atomic<bool>          hello{false};
+        std::atomic<bool>          retire{false};
+        std::atomic<bool>          finished{false};
+        bool                       replacement_requested{false};
+    };
+
+    void supervise();
+    void read(Connection& connection);
+    void requestReplacement(Connection& connection);
+    std::string openUrl();
+
+    std::string                 app_token_;
+    SocketModeOptions           options_;
+    Handler                     handler_;
+    std::shared_ptr<Deduplicator> deduplicator_;
+    std::unique_ptr<WorkerPool> pool_;
+    std::thread                 supervisor_;
+    std::mutex                  mutex_;
+    std::condition_variable     wake_;
+    std::list<std::unique_ptr<Connection>> connections_;
+    bool                        stopping_{false};
+    bool                        want_connection_{false};
+    std::atomic<std::uint64_t>  acked_{0};
+};
+
+inline
+void SocketModeClient::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (supervisor_.joinable()) { return; }
+    stopping_ = false;
+    want_connection_ = true;
+    pool_.reset(new WorkerPool{options_.workers, options_.queue_capacity});
+    supervisor_ = std::thread([this] { supervise(); });
+}
+
+inline
+void SocketModeClient::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!supervisor_.joinable()) { return; }
+        stopping_ = true;
+        wake_.notify_all();
+    }
+    supervisor_.join();
+    pool_->shutdown();
+    pool_.reset();
+}
+
+inline
+std::string SocketModeClient::openUrl() {
+    Slacking slack{app_token_};
+    if (!options_.base_url.empty()) { slack.setBaseUrl(options_.base_url); }
+    if (!options_.proxy_url.empty()) { slack.set_proxy(options_.proxy_url); }
+    auto json = slack.post("apps.connections.open", Json::object());
+    return json.value("url", "");
+}
+
+// Opens connections when asked and reaps the finished ones
+inline
+void SocketModeClient::supervise() {
+    std::chrono::seconds backoff{1};
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if ((*it)->finished) {
+                lock.unlock();
+                (*it)->thread.join();
+                lock.lock();
+                it = connections_.erase(it);
+            }
+            else { ++it; }
+        }
+        if (connections_.empty()) { want_connection_ = true; }
+
+        if (want_connection_) {
+            want_connection_ = false;
+            lock.unlock();
+            std::unique_ptr<Connection> connection{new Connection};
+            try {
+                connection->socket.reset(new WebSocket{openUrl(), options_.proxy_url});
+                backoff = std::chrono::seconds{1};
+            }
+            catch (std::exception& e) {
+                std::cerr << "[slacking] socket mode connection failed. Reason: " << e.what() << '\n';
+                connection.reset();
+            }
+            lock.lock();
+            if (connection) {
+                auto raw = connection.get();
+                connections_.push_back(std::move(connection));
+                raw->thread = std::thread([this, raw] { read(*raw); });
+            }
+            else {
+                want_connection_ = true;
+                wake_.wait_for(lock, backoff, [&] { return stopping_; });
+                backoff = std::min(backoff * 2, options_.max_backoff);
+            }
+            continue;
+        }
+        wake_.wait_for(lock, std::chrono::seconds{1});
+    }
+
+    for (auto& connection : connections_) { connection->retire = true; }
+    lock.unlock();
+    for (auto& connection : connections_) { connection->thread.join(); }
+    lock.lock();
+    connections_.clear();
+}
+
+inline
+void SocketModeClient::requestReplacement(Connection& connection) {
+    if (connection.replacement_requested) { return; }
+    connection.replacement_requested = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    want_connection_ = true;
+    wake_.notify_all();
+}
+
+inline
+void SocketModeClient::read(Connection& connection) {
+    using Clock = std::chrono::steady_clock;
+    auto& socket = *connection.socket;
+    auto refresh_at = Clock::time_point::max();
+    bool closing = false;
+    auto close_deadline = Clock::time_point::max();
+    std::string message;
+
+    try {
+        for (;;) {
+            if (connection.retire && !closing) {
+                closing = true;
+                close_deadline = Clock::now() + std::chrono::seconds{5};
+                socket.send_close(); // events still arriving until the close answer are acked
+            }
+            if (closing && Clock::now() > close_deadline) { break; }
+
+            auto status = socket.receive(message, std::chrono::milliseconds{250});
+            if (status == WebSocket::Status::Closed) { break; }
+            auto now = Clock::now();
+            if (status == WebSocket::Status::Timeout) {
+                auto silence = now - socket.last_received();
+                if (silence > 2 * options_.ping_interval) { break; }
+                if (silence > options_.ping_interval) { socket.send_ping(); }
+                if (now > refresh_at) { requestReplacement(connection); }
+                continue;
+            }
+
+            auto envelope = Json::parse(message, nullptr, false);
+            if (envelope.is_discarded()) { continue; }
+            auto type = envelope.value("type", "");
+
+            if (type == "hello") {
+                connection.hello = true;
+                auto seconds = envelope.count("debug_info") ? envelope["debug_info"].value("approximate_connection_time", 0) : 0;
+                if (seconds > 0) { refresh_at = now + std::chrono::seconds{seconds} - options_.refresh_margin; }
+                // the connections this one replaces can go
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto& other : connections_) {
+                    if (other.get() != &connection) { other->retire = true; }
+                }
+                continue;
+            }
+            if (type == "disconnect") {
+                requestReplacement(connection); // "warning" comes a few seconds before the disconnection
+                continue;
+            }
+
+            auto envelope_id = envelope.value("envelope_id", "");
+            if (envelope_id.empty()) { continue; }
+            auto key = deduplicator_ ? dedup_key(envelope) : std::string{};
+            bool duplicate = !key.empty() && deduplicator_->seen(key); // an old and a new connection may both get it
+            auto payload = std::make_shared<Json>(std::move(envelope));
+            auto handler = handler_;
+            bool queued = duplicate || !handler || pool_->submit([handler, type, payload] { handler(type, *payload); });
+            if (!queued && !key.empty()) { deduplicator_->erase(key); }
+            if (queued) { // otherwise not acked: Slack delivers it again
+                socket.send_text(Json{{"envelope_id", envelope_id}}.dump());
+                ++acked_;
+            }
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "[slacking] socket mode connection lost. Reason: " << e.what() << '\n';
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection.finished = true;
+        wake_.notify_all();
+    }
+}
+
+} // namespace _detail
+
+using _detail::SocketModeOptions;
+using _detail::SocketModeClient;
+
+} // namespace slack
+
+#endif // SLACKING_SOCKET_MODE_HPP_
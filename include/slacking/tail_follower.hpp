@@ -0,0 +1,298 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: follow new messages of many channels by polling conversations.history.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_TAIL_FOLLOWER_HPP_
+#define SLACKING_TAIL_FOLLOWER_HPP_
+
+#include "slacking.hpp"
+#include "methods.hpp"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+
+namespace slack {
+
+namespace _detail {
+
+struct FollowerOptions {
+    std::string watermark_file{};               // empty: watermarks are not persisted
+    std::string base_url{};                     // empty: the default Slack Web API url
+    std::chrono::milliseconds min_interval{2000};   // polling interval of a busy channel
+    std::chrono::milliseconds max_interval{300000}; // polling interval of an idle channel
+    double      backoff{2.0};                   // interval growth after each poll without message
+    unsigned    page_limit{200};
+};
+
+// Compare two Slack timestamps ("1512085950.000216") without converting them
+inline
+bool ts_less(const std::string& a, const std::string& b) {
+    auto a_dot = a.find('.'), b_dot = b.find('.');
+    if (a_dot != b_dot) { return a_dot < b_dot; }
+    return a < b;
+}
+
+// Poll conversations.history for new messages of many channels and deliver them, oldest first, to a callback.
+// Every channel keeps an `oldest` watermark (persisted in FollowerOptions::watermark_file) so that only new
+// messages are fetched, even after a restart. The polling interval of a channel is reset to min_interval
+// when it had new messages and grows up to max_interval while it stays idle. All channels share the rate
+// limit of conversations.history, which is a global budget for the workspace.
+class ChannelFollower {
+public:
+    using Callback = std::function<void(const std::string& channel, const Message& message)>;
+    using Clock    = std::chrono::steady_clock;
+
+    ChannelFollower(const std::string& token, Callback callback, FollowerOptions options = FollowerOptions{})
+        : slack_{token}, callback_{callback}, options_(options), own_limiter_{new RateLimiter{}}, limiter_{own_limiter_.get()} {
+        if (!options_.base_url.empty()) { slack_.setBaseUrl(options_.base_url); }
+        loadWatermarks();
+    }
+
+    ~ChannelFollower() { stop(); }
+
+    ChannelFollower(const ChannelFollower&)            = delete;
+    ChannelFollower& operator=(const ChannelFollower&) = delete;
+
+    // Share the budget of conversations.history with other components using the same token
+    void set_rate_limiter(RateLimiter& limiter) { limiter_ = &limiter; }
+
+    // A channel without watermark is followed from now on
+    void follow(const std::string& channel);
+    void unfollow(const std::string& channel);
+
+    // Poll in a background thread until stop()
+    void start();
+    void stop();
+
+    // Wait for the next due channel and poll it. Return false if no channel is followed.
+    bool poll_once();
+
+    std::string watermark(const std::string& channel) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = channels_.find(channel);
+        return it == channels_.end() ? std::string{} : it->second.watermark;
+    }
+
+private:
+    struct ChannelState {
+        std::string               watermark{};
+        Clock::duration           interval{};
+        unsigned                  generation{0}; // invalidates the schedule entries of an unfollowed channel
+        bool                      followed{false};
+    };
+
+    struct Due {
+        Clock::time_point when;
+        std::string       channel;
+        unsigned          generation;
+        bool operator>(const Due& other) const { return when > other.when; }
+    };
+
+    bool poll(const std::string& channel, std::string watermark);
+    void schedule(const std::string& channel, bool had_messages, bool failed);
+    void loadWatermarks();
+    void saveWatermarks();
+
+    static std::string now_ts() {
+        return std::to_string(static_cast<long long>(std::time(nullptr))) + ".000000";
+    }
+
+    Slacking                     slack_;
+    Callback                     callback_;
+    FollowerOptions              options_;
+    std::unique_ptr<RateLimiter> own_limiter_;
+    RateLimiter*                 limiter_;
+
+    mutable std::mutex           mutex_;
+    std::condition_variable      wake_;
+    std::map<std::string, ChannelState> channels_;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> schedule_;
+    std::thread                  thread_;
+    bool                         running_{false};
+    bool                         stopping_{false};
+};
+
+inline
+void ChannelFollower::follow(const std::string& channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& state = channels_[channel];
+    if (state.followed) { return; }
+    state.followed = true;
+    state.interval = options_.min_interval;
+    if (state.watermark.empty()) { state.watermark = now_ts(); }
+    schedule_.push(Due{Clock::now(), channel, ++state.generation});
+    wake_.notify_all();
+}
+
+inline
+void ChannelFollower::unfollow(const std::string& channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = channels_.find(channel);
+    if (it == channels_.end()) { return; }
+    it->second.followed = false;
+    ++it->second.generation;
+}
+
+inline
+void ChannelFollower::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) { return; }
+    running_  = true;
+    stopping_ = false;
+    thread_ = std::thread([this] {
+        while (poll_once()) {}
+    });
+}
+
+inline
+void ChannelFollower::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) { return; }
+        stopping_ = true;
+        wake_.notify_all();
+    }
+    thread_.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+}
+
+inline
+bool ChannelFollower::poll_once() {
+    std::string channel, watermark;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            if (stopping_) { return false; }
+            if (schedule_.empty()) {
+                if (!running_) { return false; }
+                wake_.wait(lock);
+                continue;
+            }
+            auto due = schedule_.top();
+            auto it = channels_.find(due.channel);
+            if (it == channels_.end() || it->second.generation != due.generation) { schedule_.pop(); continue; }
+            if (wake_.wait_until(lock, due.when) == std::cv_status::no_timeout) { continue; } // woken up: the schedule may have changed
+            if (Clock::now() < due.when) { continue; }
+            schedule_.pop();
+            channel   = due.channel;
+            watermark = it->second.watermark;
+            break;
+        }
+    }
+
+    bool had_messages = false, failed = false;
+    try { had_messages = poll(channel, watermark); }
+    catch (RateLimited& e) {
+        limiter_->penalize(methods::conversations_history.name, std::max(1l, e.retry_after()));
+    }
+    catch (std::exception& e) {
+        failed = true;
+        std::cerr << "[slacking] polling " << channel << " failed. Reason: " << e.what() << '\n';
+    }
+    schedule(channel, had_messages, failed);
+    return true;
+}
+
+inline
+bool ChannelFollower::poll(const std::string& channel, std::string watermark) {
+    std::vector<Message> messages;
+    std::string cursor{};
+    do {
+        Json arguments = {{"channel", channel}, {"oldest", watermark}, {"limit", options_.page_limit}};
+        if (!cursor.empty()) { arguments["cursor"] = cursor; }
+        limiter_->acquire(methods::conversations_history.name, methods::conversations_history.tier);
+        auto page = slack_.post_decoded<Message>(methods::conversations_history.name, "messages", arguments);
+        std::move(page.items.begin(), page.items.end(), std::back_inserter(messages));
+        cursor = std::move(page.next_cursor);
+    } while (!cursor.empty());
+
+    // pages come newest first
+    std::sort(messages.begin(), messages.end(), [](const Message& a, const Message& b) { return ts_less(a.ts, b.ts); });
+
+    std::string delivered = watermark;
+    try {
+        for (auto const& message : messages) {
+            if (!ts_less(delivered, message.ts)) { continue; }
+            callback_(channel, message);
+            delivered = message.ts;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "[slacking] callback failed on " << channel << ", delivery resumes at next poll. Reason: " << e.what() << '\n';
+    }
+
+    if (delivered != watermark) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        channels_[channel].watermark = delivered;
+        saveWatermarks();
+    }
+    return !messages.empty();
+}
+
+inline
+void ChannelFollower::schedule(const std::string& channel, bool had_messages, bool failed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& state = channels_[channel];
+    if (!state.followed) { return; }
+    if (had_messages) {
+        state.interval = options_.min_interval;
+    }
+    else if (failed) {
+        state.interval = options_.max_interval;
+    }
+    else {
+        auto grown = std::chrono::duration_cast<Clock::duration>(state.interval * options_.backoff);
+        state.interval = std::min<Clock::duration>(grown, options_.max_interval);
+    }
+    schedule_.push(Due{Clock::now() + state.interval, channel, state.generation});
+}
+
+inline
+void ChannelFollower::loadWatermarks() {
+    if (options_.watermark_file.empty()) { return; }
+    std::ifstream file(options_.watermark_file);
+    if (!file) { return; }
+    auto json = Json::parse(file, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        throw std::runtime_error("[slacking] corrupted watermark file " + options_.watermark_file);
+    }
+    for (auto it = json.begin(); it != json.end(); ++it) {
+        channels_[it.key()].watermark = it.value().get<std::string>();
+    }
+}
+
+// Saved after every delivery: readers of the file see the previous watermarks or the new ones, never a mix
+inline
+void ChannelFollower::saveWatermarks() {
+    if (options_.watermark_file.empty()) { return; }
+    auto json = Json::object();
+    for (auto const& channel : channels_) {
+        if (!channel.second.watermark.empty()) { json[channel.first] = channel.second.watermark; }
+    }
+    auto tmp_path = options_.watermark_file + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << json.dump();
+        if (!file.flush()) { throw std::runtime_error("[slacking] cannot write watermark file " + tmp_path); }
+    }
+    if (!replace_file(tmp_path, options_.watermark_file)) {
+        throw std::runtime_error("[slacking] cannot rename watermark file " + tmp_path);
+    }
+}
+
+} // namespace _detail
+
+using _detail::FollowerOptions;
+using _detail::ChannelFollower;
+
+} // namespace slack
+
+#endif // SLACKING_TAIL_FOLLOWER_HPP_
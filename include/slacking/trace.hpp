@@ -0,0 +1,226 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: record the Web API traffic to a trace file and replay it without network.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_TRACE_HPP_
+#define SLACKING_TRACE_HPP_
+
+#include "slacking.hpp"
+
+#include <fstream>
+#include <map>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+// A trace file is a header line then, per exchange, one line of Json metadata followed by the raw request body,
+// response headers and response body whose sizes it gives. Bodies are neither escaped nor re-encoded:
+// recording a 30 MB users.list costs a copy, not a serialization.
+static const char* const trace_magic = "slacking-trace 1";
+
+// Record the requests of one or many Slacking instances (record_to()) with their answers and timing.
+// Tokens are redacted from the request bodies and cookies from the response headers by default.
+class TraceRecorder {
+public:
+    explicit TraceRecorder(const std::string& path, bool redact = true)
+        : path_{path}, redact_{redact}, file_{path, std::ios::binary | std::ios::trunc}, start_{std::chrono::steady_clock::now()} {
+        if (!file_) { throw std::runtime_error("[slacking] cannot open " + path_); }
+        file_ << trace_magic << '\n';
+    }
+
+    TraceRecorder(const TraceRecorder&)            = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void record(const Exchange& exchange) {
+        auto request_body     = redact_ ? redactToken(exchange.request_body) : exchange.request_body;
+        auto response_headers = redact_ ? redactCookies(exchange.response_headers) : exchange.response_headers;
+        auto micros = [](std::chrono::microseconds d) { return static_cast<long long>(d.count()); };
+        auto const& t = exchange.timing;
+        auto at = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_) - t.total;
+
+        Json meta = {{"verb", exchange.verb}, {"url", exchange.url}, {"status", exchange.status_code}, {"at", micros(at)},
+                     {"request_bytes", request_body.size()}, {"header_bytes", response_headers.size()}, {"body_bytes", exchange.response_body.size()},
+                     {"namelookup", micros(t.namelookup)}, {"connect", micros(t.connect)}, {"appconnect", micros(t.appconnect)},
+                     {"pretransfer", micros(t.pretransfer)}, {"starttransfer", micros(t.starttransfer)}, {"total", micros(t.total)},
+                     {"reused", t.reused_connection}};
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_ << meta.dump() << '\n' << request_body << response_headers << exchange.response_body;
+        if (!file_.flush()) { throw std::runtime_error("[slacking] cannot write " + path_); }
+        ++count_;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+private:
+    static std::string redactToken(const std::string& body) {
+        auto out = body;
+        for (auto position = out.find("token="); position != std::string::npos; position = out.find("token=", position + 1)) {
+            if (position > 0 && out[position - 1] != '&' && out[position - 1] != '?') { continue; }
+            auto value = position + 6;
+            auto end = out.find('&', value);
+            out.replace(value, (end == std::string::npos ? out.size() : end) - value, "REDACTED");
+        }
+        return out;
+    }
+
+    static std::string redactCookies(const std::string& headers) {
+        std::string out, line;
+        std::istringstream stream{headers};
+        while (std::getline(stream, line)) {
+            static const std::string name{"set-cookie:"};
+            if (line.size() > name.size() && std::equal(name.begin(), name.end(), line.begin(),
+                    [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) { continue; }
+            out += line;
+            out += '\n';
+        }
+        return out;
+    }
+
+    std::string        path_;
+    bool               redact_;
+    std::ofstream      file_;
+    std::chrono::steady_clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::size_t        count_{0};
+};
+
+struct ReplayOptions {
+    double timing_scale{1.0}; // each answer takes its recorded time multiplied by it, 0: answers at once
+    bool   loop{false};       // start over the answers to a request once they are all used, instead of failing
+
+    ReplayOptions() = default;
+    ReplayOptions(double s, bool l) : timing_scale{s}, loop{l} {}
+};
+
+// Transport answering the requests of Slacking instances (replay_from()) with the exchanges of a trace file.
+// A request is answered with the next recorded exchange of the same verb and path (the host is ignored, so a
+// trace recorded against slack.com answers a Slacking pointed elsewhere), in the order they were recorded.
+class TraceReplayer : public Transport {
+public:
+    explicit TraceReplayer(const std::string& path, ReplayOptions options = ReplayOptions{}) : options_(options) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { throw std::runtime_error("[slacking] cannot open " + path); }
+        std::string line;
+        if (!std::getline(file, line) || line != trace_magic) { throw std::runtime_error("[slacking] not a trace file " + path); }
+
+        auto read = [&file, &path](std::size_t size) {
+            std::string bytes(size, '\0');
+            if (size > 0 && !file.read(&bytes[0], static_cast<std::streamsize>(size))) { throw std::runtime_error("[slacking] truncated trace file " + path); }
+            return bytes;
+        };
+        auto micros = [](const Json& meta, const char* key) { return std::chrono::microseconds{meta.value(key, 0ll)}; };
+        while (std::getline(file, line)) {
+            auto meta = Json::parse(line, nullptr, false);
+            if (meta.is_discarded() || !meta.is_object()) { throw std::runtime_error("[slacking] corrupted trace file " + path); }
+            Exchange exchange{};
+            exchange.verb             = meta.value("verb", "POST");
+            exchange.url              = meta.value("url", "");
+            exchange.status_code      = meta.value("status", 0l);
+            exchange.request_body     = read(meta.value("request_bytes", std::size_t{0}));
+            exchange.response_headers = read(meta.value("header_bytes", std::size_t{0}));
+            exchange.response_body    = read(meta.value("body_bytes", std::size_t{0}));
+
+            auto& t = exchange.timing;
+            t.url               = exchange.url;
+            t.status_code       = exchange.status_code;
+            t.namelookup        = micros(meta, "namelookup");
+            t.connect           = micros(meta, "connect");
+            t.appconnect        = micros(meta, "appconnect");
+            t.pretransfer       = micros(meta, "pretransfer");
+            t.starttransfer     = micros(meta, "starttransfer");
+            t.total             = micros(meta, "total");
+            t.bytes_sent        = exchange.request_body.size();
+            t.bytes_received    = exchange.response_body.size();
+            t.reused_connection = meta.value("reused", false);
+
+            queues_[key(exchange.verb, exchange.url)].indexes.push_back(exchanges_.size());
+            exchanges_.push_back(std::move(exchange));
+        }
+    }
+
+    TraceReplayer(const TraceReplayer&)            = delete;
+    TraceReplayer& operator=(const TraceReplayer&) = delete;
+
+    bool perform(const TransportRequest& request, TransportResult& result, bool want_timing) override {
+        const Exchange* recorded = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto queue = queues_.find(key(request.verb.str(), request.url.str()));
+            if (queue != queues_.end() && queue->second.next == queue->second.indexes.size() && options_.loop) { queue->second.next = 0; }
+            if (queue == queues_.end() || queue->second.next == queue->second.indexes.size()) {
+                result.error = "no recorded answer to " + request.verb.str() + ' ' + request.url.str();
+                return false;
+            }
+            recorded = &exchanges_[queue->second.indexes[queue->second.next++]];
+        }
+        if (options_.timing_scale > 0) {
+            std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::microseconds>(recorded->timing.total * options_.timing_scale));
+        }
+        result.status_code = recorded->status_code;
+        result.headers     = recorded->response_headers;
+        result.body        = recorded->response_body; // the trace can be replayed again
+        if (want_timing) {
+            result.timing     = recorded->timing;
+            result.timing.url = request.url.str();
+        }
+        return true;
+    }
+
+    bool thread_safe() const override { return true; }
+
+    // Every exchange of the trace, in the order recorded: e.g. to benchmark the decoding of the bodies alone
+    const std::vector<Exchange>& exchanges() const { return exchanges_; }
+
+    // Replay the trace again from its start
+    void rewind() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& queue : queues_) { queue.second.next = 0; }
+    }
+
+private:
+    struct Queue {
+        std::vector<std::size_t> indexes;
+        std::size_t              next{0};
+    };
+
+    // verb and path of the url, without scheme and host
+    static std::string key(const std::string& verb, const std::string& url) {
+        auto scheme = url.find("://");
+        auto path = scheme == std::string::npos ? url : url.substr(std::min(url.size(), url.find('/', scheme + 3)));
+        return verb + ' ' + path;
+    }
+
+    ReplayOptions                 options_;
+    std::vector<Exchange>         exchanges_;
+    std::map<std::string, Queue>  queues_;
+    std::mutex                    mutex_;
+};
+
+inline
+void record_to(Slacking& slack, std::shared_ptr<TraceRecorder> recorder) {
+    slack.set_recorder([recorder](const Exchange& exchange) { recorder->record(exchange); });
+}
+
+inline
+void replay_from(Slacking& slack, std::shared_ptr<TraceReplayer> replayer) {
+    slack.set_transport(replayer);
+}
+
+} // namespace _detail
+
+using _detail::TraceRecorder;
+using _detail::ReplayOptions;
+using _detail::TraceReplayer;
+using _detail::record_to;
+using _detail::replay_from;
+
+} // namespace slack
+
+#endif // SLACKING_TRACE_HPP_
@@ -0,0 +1,415 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: file uploads streamed from disk through files.getUploadURLExternal and files.completeUploadExternal.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_UPLOAD_HPP_
+#define SLACKING_UPLOAD_HPP_
+
+#include "slacking.hpp"
+#include "methods.hpp"
+#include "signature.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace slack {
+
+namespace _detail {
+
+struct UploadProgress {
+    std::string   filename;
+    std::uint64_t sent{0};   // bytes
+    std::uint64_t total{0};
+};
+
+struct UploadOptions {
+    std::string channel_id{};       // share the file in this channel, empty to keep it private
+    std::string thread_ts{};        // as a reply in this thread of channel_id
+    std::string initial_comment{};
+    std::string title{};            // empty for the filename
+    std::string filename{};         // empty for the last component of the path
+    std::function<void(const UploadProgress&)> progress{}; // called by the thread uploading as the bytes are sent
+
+    UploadOptions() = default;
+};
+
+struct UploadedFile {
+    std::string   id;
+    std::string   title;
+    std::string   permalink;
+    std::uint64_t size{0};
+    bool          cached{false}; // same bytes as a file uploaded before, shared again instead of uploaded
+};
+
+// Lower case hex of a SHA-256 digest, the key of the files in UploadCache
+inline std::string hex_digest(const Sha256::Digest& digest) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (auto byte : digest) { text += digits[byte >> 4]; text += digits[byte & 0xf]; }
+    return text;
+}
+
+// Files uploaded so far by SHA-256 of their bytes, so that the same bytes are shared again rather than uploaded
+// again. At most capacity files are remembered, the least recently used forgotten first. With a path, the cache
+// is loaded from it and written back (to path.tmp, then renamed) at every change, one Json object per line.
+// Thread safe: one cache may serve several uploaders.
+class UploadCache {
+public:
+    explicit UploadCache(const std::string& path = "", std::size_t capacity = 1024) : path_{path}, capacity_{std::max<std::size_t>(1, capacity)} {
+        if (!path_.empty()) { load(); }
+    }
+
+    UploadCache(const UploadCache&)            = delete;
+    UploadCache& operator=(const UploadCache&) = delete;
+
+    bool find(const std::string& digest, UploadedFile& file) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(digest);
+        if (it == index_.end()) { return false; }
+        files_.splice(files_.begin(), files_, it->second);
+        file = it->second->second;
+        save();
+        return true;
+    }
+
+    void insert(const std::string& digest, const UploadedFile& file) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remember(digest, file);
+        save();
+    }
+
+    // e.g. once the file is deleted from Slack
+    void erase(const std::string& digest) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(digest);
+        if (it == index_.end()) { return; }
+        files_.erase(it->second);
+        index_.erase(it);
+        save();
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return files_.size();
+    }
+
+private:
+    using Entry = std::pair<std::string, UploadedFile>; // digest, file
+
+    void remember(const std::string& digest, const UploadedFile& file) {
+        auto it = index_.find(digest);
+        if (it != index_.end()) { files_.erase(it->second); }
+        files_.emplace_front(digest, file);
+        files_.front().second.cached = false;
+        index_[digest] = files_.begin();
+        if (files_.size() > capacity_) {
+            index_.erase(files_.back().first);
+            files_.pop_back();
+        }
+    }
+
+    void load();
+    void save();
+
+    std::string                                                  path_;
+    std::size_t                                                  capacity_;
+    mutable std::mutex                                           mutex_;
+    std::list<Entry>                                             files_; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+inline
+void UploadCache::load() {
+    std::ifstream in(path_);
+    std::vector<Json> lines;
+    for (std::string line; std::getline(in, line); ) {
+        auto json = Json::parse(line, nullptr, false);
+        if (json.is_object() && json.count("sha256") && json.count("id")) { lines.push_back(std::move(json)); }
+    }
+    for (auto it = lines.rbegin(); it != lines.rend(); ++it) { // written most recent first
+        UploadedFile file;
+        file.id        = (*it)["id"].get<std::string>();
+        file.title     = it->value("title", "");
+        file.permalink = it->value("permalink", "");
+        file.size      = it->value("size", std::uint64_t{0});
+        remember((*it)["sha256"].get<std::string>(), file);
+    }
+}
+
+// Failing to write the cache costs uploads, not correctness: reported, not thrown
+inline
+void UploadCache::save() {
+    if (path_.empty()) { return; }
+    auto tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (auto const& entry : files_) {
+            out << Json{{"sha256", entry.first}, {"id", entry.second.id}, {"title", entry.second.title},
+                        {"permalink", entry.second.permalink}, {"size", entry.second.size}}.dump() << '\n';
+        }
+        if (!out.flush()) {
+            std::cerr << "[slacking] upload cache not saved. Reason: cannot write " << tmp << '\n';
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        std::cerr << "[slacking] upload cache not saved. Reason: cannot rename " << tmp << " to " << path_ << '\n';
+    }
+}
+
+// Upload of files with the flow replacing files.upload: files.getUploadURLExternal gives a url, the bytes are
+// posted to it, files.completeUploadExternal shares the file. The bytes are streamed from disk in chunks by
+// curl, so memory stays the same whatever the size of the file.
+//
+//     slack::FileUploader uploader{slack::instance()};
+//     slack::UploadOptions options;
+//     options.channel_id = "C0123456";
+//     auto report = uploader.upload_async("report.pdf", options); // std::future<slack::UploadedFile>
+//
+// Up to concurrency files are sent at once by the threads of the uploader, each over a connection kept alive.
+// The Web API calls go through slack, with its token, rate limiter and observer. Errors are thrown, or set
+// in the future: std::runtime_error for a file which cannot be read or a refused upload.
+// With set_cache(), a file whose bytes were uploaded before is not uploaded again: it is shared in the channel
+// by a message linking to it, which Slack unfurls, unless it was deleted from Slack in the meantime.
+// The destructor waits for the uploads queued.
+class FileUploader {
+public:
+    explicit FileUploader(Slacking& slack, unsigned concurrency = 4) : slack_(slack), queue_{1024} {
+        curl_global_init(CURL_GLOBAL_ALL);
+        for (unsigned i = 0; i < std::max(1u, concurrency); ++i) { workers_.emplace_back([this] { work(); }); }
+    }
+
+    ~FileUploader() {
+        queue_.close();
+        for (auto& worker : workers_) { worker.join(); }
+        for (auto curl : idle_) { curl_easy_cleanup(curl); }
+        curl_global_cleanup();
+    }
+
+    FileUploader(const FileUploader&)            = delete;
+    FileUploader& operator=(const FileUploader&) = delete;
+
+    // Upload in the calling thread
+    UploadedFile upload(const std::string& path, const UploadOptions& options = UploadOptions{});
+
+    // Look the files up by their bytes in cache before uploading them, and add the files uploaded. Set it before uploading.
+    void set_cache(std::shared_ptr<UploadCache> cache) { cache_ = cache; }
+
+    // Upload by the threads of the uploader, blocking while 1024 uploads are waiting already
+    std::future<UploadedFile> upload_async(const std::string& path, UploadOptions options = UploadOptions{}) {
+        auto task = std::make_shared<std::packaged_task<UploadedFile()>>([this, path, options] { return upload(path, options); });
+        auto result = task->get_future();
+        if (!queue_.push([task] { (*task)(); })) { throw std::runtime_error("[slacking] uploader stopped"); }
+        return result;
+    }
+
+private:
+    struct Transfer {
+        std::ifstream        file;
+        UploadProgress       progress;
+        const UploadOptions* options;
+    };
+
+    void send(const std::string& upload_url, Transfer& transfer);
+    bool exists(const std::string& file_id);
+    void share(const UploadedFile& file, const UploadOptions& options);
+    void work();
+
+    static std::string digest(std::ifstream& file) {
+        Sha256 sha256;
+        std::unique_ptr<char[]> buffer{new char[1 << 16]};
+        while (file.read(buffer.get(), 1 << 16) || file.gcount() > 0) {
+            sha256.update(buffer.get(), static_cast<std::size_t>(file.gcount()));
+        }
+        file.clear();
+        file.seekg(0);
+        return hex_digest(sha256.finish());
+    }
+
+    CURL* checkout() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                auto curl = idle_.back();
+                idle_.pop_back();
+                return curl;
+            }
+        }
+        auto curl = curl_easy_init();
+        if (!curl) { throw std::runtime_error("[slacking] curl_easy_init() failed"); }
+        return curl;
+    }
+
+    void checkin(CURL* curl) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(curl);
+    }
+
+    static size_t readFunction(char* buffer, size_t size, size_t nitems, void* userdata) {
+        auto& file = static_cast<Transfer*>(userdata)->file;
+        file.read(buffer, static_cast<std::streamsize>(size * nitems));
+        return static_cast<size_t>(file.gcount());
+    }
+
+    static int progressFunction(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t ulnow) {
+        auto& transfer = *static_cast<Transfer*>(userdata);
+        if (static_cast<std::uint64_t>(ulnow) != transfer.progress.sent) {
+            transfer.progress.sent = static_cast<std::uint64_t>(ulnow);
+            transfer.options->progress(transfer.progress);
+        }
+        return 0;
+    }
+
+    static size_t writeFunction(void* ptr, size_t size, size_t nmemb, std::string* data) {
+        data->append(static_cast<char*>(ptr), size * nmemb);
+        return size * nmemb;
+    }
+
+    Slacking&                            slack_;
+    std::shared_ptr<UploadCache>         cache_;
+    BlockingQueue<std::function<void()>> queue_;
+    std::vector<std::thread>             workers_;
+    std::mutex                           mutex_;  // idle_
+    std::vector<CURL*>                   idle_;
+};
+
+inline
+UploadedFile FileUploader::upload(const std::string& path, const UploadOptions& options) {
+    Transfer transfer;
+    transfer.file.open(path, std::ios::binary | std::ios::ate);
+    if (!transfer.file) { throw std::runtime_error("[slacking] cannot read " + path); }
+    transfer.options           = &options;
+    transfer.progress.total    = static_cast<std::uint64_t>(transfer.file.tellg());
+    transfer.progress.filename = !options.filename.empty() ? options.filename : path.substr(path.find_last_of("/\\") + 1);
+    transfer.file.seekg(0);
+
+    std::string sha256;
+    if (cache_) {
+        sha256 = digest(transfer.file);
+        UploadedFile known;
+        if (cache_->find(sha256, known)) {
+            if (exists(known.id)) {
+                share(known, options);
+                known.cached = true;
+                transfer.progress.sent = transfer.progress.total;
+                if (options.progress) { options.progress(transfer.progress); }
+                return known;
+            }
+            cache_->erase(sha256);
+        }
+    }
+
+    auto url = slack_.call(methods::files_getUploadURLExternal, Json{{"filename", transfer.progress.filename}, {"length", transfer.progress.total}});
+    if (!url.value("ok", false)) { throw std::runtime_error("[slacking] files.getUploadURLExternal failed for " + path + ": " + url.dump()); }
+    auto file_id = url["file_id"].get<std::string>();
+
+    send(url["upload_url"].get<std::string>(), transfer);
+
+    auto title = !options.title.empty() ? options.title : transfer.progress.filename;
+    Json arguments = {{"files", Json::array({Json{{"id", file_id}, {"title", title}}}).dump()}};
+    if (!options.channel_id.empty())      { arguments["channel_id"]      = options.channel_id; }
+    if (!options.thread_ts.empty())       { arguments["thread_ts"]       = options.thread_ts; }
+    if (!options.initial_comment.empty()) { arguments["initial_comment"] = options.initial_comment; }
+    auto complete = slack_.call(methods::files_completeUploadExternal, arguments);
+    if (!complete.value("ok", false)) { throw std::runtime_error("[slacking] files.completeUploadExternal failed for " + path + ": " + complete.dump()); }
+
+    UploadedFile uploaded;
+    uploaded.id    = file_id;
+    uploaded.title = title;
+    uploaded.size  = transfer.progress.total;
+    if (complete.count("files") && complete["files"].is_array() && !complete["files"].empty()) {
+        uploaded.permalink = complete["files"][0].value("permalink", "");
+    }
+    if (cache_) { cache_->insert(sha256, uploaded); }
+    return uploaded;
+}
+
+// Whether a file is still on Slack: files.info fails with file_not_found or file_deleted once it is removed
+inline
+bool FileUploader::exists(const std::string& file_id) {
+    std::string error;
+    try {
+        auto info = slack_.call(methods::files_info, Json{{"file", file_id}});
+        if (info.value("ok", false)) { return true; }
+        error = info.value("error", "");
+    }
+    catch (std::runtime_error& e) {
+        error = e.what();
+    }
+    if (error.find("file_not_found") != std::string::npos || error.find("file_deleted") != std::string::npos) { return false; }
+    throw std::runtime_error("[slacking] files.info failed for " + file_id + ": " + error);
+}
+
+// Post the permalink of a cached file where it would have been shared, which Slack shows as the file
+inline
+void FileUploader::share(const UploadedFile& file, const UploadOptions& options) {
+    if (options.channel_id.empty()) { return; }
+    auto text = options.initial_comment.empty() ? file.permalink : options.initial_comment + '\n' + file.permalink;
+    Json arguments = {{"channel", options.channel_id}, {"text", text}, {"unfurl_links", true}, {"unfurl_media", true}};
+    if (!options.thread_ts.empty()) { arguments["thread_ts"] = options.thread_ts; }
+    auto posted = slack_.call(methods::chat_postMessage, arguments);
+    if (!posted.value("ok", false)) { throw std::runtime_error("[slacking] chat.postMessage failed for " + file.id + ": " + posted.dump()); }
+}
+
+// Post the bytes of the file to the url given by files.getUploadURLExternal, read by curl as it sends them
+inline
+void FileUploader::send(const std::string& upload_url, Transfer& transfer) {
+    auto curl = checkout();
+    std::string body;
+    curl_header header(curl);
+    header.append("Content-Type: application/octet-stream");
+
+    curl_easy_setopt(curl, CURLOPT_URL, upload_url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(transfer.progress.total));
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, readFunction);
+    curl_easy_setopt(curl, CURLOPT_READDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header.list());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, transfer.options->progress ? 0L : 1L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progressFunction);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer);
+
+    auto res = curl_easy_perform(curl);
+    long status_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr); // the list is freed with header
+    curl_easy_setopt(curl, CURLOPT_READDATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, nullptr);
+    checkin(curl);
+
+    if (res != CURLE_OK) {
+        throw std::runtime_error("[slacking] upload of " + transfer.progress.filename + " failed. Reason: " + curl_easy_strerror(res));
+    }
+    if (status_code != 200) {
+        throw std::runtime_error("[slacking] upload of " + transfer.progress.filename + " refused with " + std::to_string(status_code) + ' ' + body);
+    }
+}
+
+inline
+void FileUploader::work() {
+    std::function<void()> task;
+    while (queue_.pop(task)) { task(); } // the packaged_task keeps the exceptions for the future
+}
+
+} // namespace _detail
+
+using _detail::UploadProgress;
+using _detail::UploadOptions;
+using _detail::UploadedFile;
+using _detail::UploadCache;
+using _detail::FileUploader;
+
+} // namespace slack
+
+#endif // SLACKING_UPLOAD_HPP_
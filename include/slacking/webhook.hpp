@@ -0,0 +1,200 @@
+// Slacking, a modern C++ 11 library for communicating with the Web Slack API
+// https://github.com/coin-au-carre/slacking
+//
+// Optional header: incoming webhook client spreading messages over many webhook urls, each paced at Slack's limit.
+// Licensed under the MIT License, see slacking.hpp.
+
+#ifndef SLACKING_WEBHOOK_HPP_
+#define SLACKING_WEBHOOK_HPP_
+
+#include "slacking.hpp"
+
+#include <atomic>
+#include <memory>
+
+namespace slack {
+
+namespace _detail {
+
+struct WebhookOptions {
+    double      per_second{1.0};       // messages per url and per second, Slack's limit for incoming webhooks. 0: unpaced
+    unsigned    burst{1};              // messages a url may send at once after a quiet period
+    unsigned    max_retries{5};        // per message, on 429, 5xx or no answer: each time on the url available first
+    std::size_t queue_bytes{8 << 20};  // of the messages waiting in the queue of enqueue(), which blocks beyond
+    unsigned    senders{0};            // threads sending the queued messages, 0 for one per url
+
+    WebhookOptions() = default;
+};
+
+struct WebhookStats {
+    std::uint64_t sent{0};
+    std::uint64_t retried{0};  // attempts which failed then were retried
+    std::uint64_t failed{0};   // messages given up
+};
+
+// Client of the incoming webhooks of one channel, e.g. for alerting. Slack takes about one message per second
+// on a webhook: given several webhook urls of the same channel, each message goes to the url available first,
+// so n urls sustain n messages per second. A url answering 429 is held for the delay asked.
+// Messages are Json bodies posted as is to the urls, over connections kept alive (PooledCurlTransport).
+//
+//     slack::WebhookClient alerts{{"https://hooks.slack.com/services/T0/B1/XXX", "https://hooks.slack.com/services/T0/B2/YYY"}};
+//     alerts.enqueue({{"text", "disk full on db-3"}}); // returns at once, sent by the threads of the client
+//
+// Thread safe. The destructor sends the messages still queued.
+class WebhookClient {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit WebhookClient(const std::vector<std::string>& urls, WebhookOptions options = WebhookOptions{},
+                           std::shared_ptr<Transport> transport = nullptr)
+        : options_(options), transport_{transport ? transport : std::make_shared<PooledCurlTransport>()},
+          queue_{options.queue_bytes} {
+        if (urls.empty()) { throw std::runtime_error("[slacking] no webhook url"); }
+        for (auto const& url : urls) { shards_.emplace_back(url); }
+        if (options_.per_second > 0) {
+            interval_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options_.per_second));
+        }
+        auto senders = options_.senders > 0 ? options_.senders : static_cast<unsigned>(urls.size());
+        for (unsigned i = 0; i < senders; ++i) { senders_.emplace_back([this] { drain(); }); }
+    }
+
+    ~WebhookClient() {
+        queue_.close();
+        for (auto& sender : senders_) { sender.join(); }
+    }
+
+    WebhookClient(const WebhookClient&)            = delete;
+    WebhookClient& operator=(const WebhookClient&) = delete;
+
+    // Send now, waiting for a url to be available. false once the message is given up.
+    bool post(const Json& message) { return post_raw(message.dump()); }
+    bool post_raw(const std::string& body);
+
+    // Queue for the sender threads, blocking while the queue is full. false if the client is being destroyed.
+    bool enqueue(const Json& message) { return enqueue_raw(message.dump()); }
+    bool enqueue_raw(std::string body) {
+        ++pending_;
+        auto cost = body.size();
+        if (queue_.push(std::move(body), cost)) { return true; }
+        done();
+        return false;
+    }
+
+    // Wait until every queued message is sent or given up
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushed_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    WebhookStats stats() const {
+        WebhookStats stats;
+        stats.sent    = sent_;
+        stats.retried = retried_;
+        stats.failed  = failed_;
+        return stats;
+    }
+
+private:
+    struct Shard {
+        explicit Shard(const std::string& u) : url{u} {}
+        std::string       url;
+        Clock::time_point tat{}; // theoretical arrival time of the next message, as in RateLimiter
+    };
+
+    std::size_t acquire();
+    void penalize(std::size_t shard, long retry_after);
+    void drain();
+
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) { flushed_.notify_all(); }
+    }
+
+    WebhookOptions             options_;
+    std::shared_ptr<Transport> transport_;
+    Clock::duration            interval_{Clock::duration::zero()};
+    std::vector<Shard>         shards_;
+    std::mutex                 mutex_;  // shards_ and flush()
+    std::condition_variable    flushed_;
+    BlockingQueue<std::string> queue_;
+    std::vector<std::thread>   senders_;
+    std::atomic<std::size_t>   pending_{0};
+    std::atomic<std::uint64_t> sent_{0};
+    std::atomic<std::uint64_t> retried_{0};
+    std::atomic<std::uint64_t> failed_{0};
+};
+
+inline
+bool WebhookClient::post_raw(const std::string& body) {
+    static const std::string content_type{"application/json; charset=utf-8"};
+    for (unsigned attempt = 0; ; ++attempt) {
+        auto shard = acquire();
+        TransportResult result;
+        bool answered = transport_->perform(TransportRequest{BufferView{"POST", 4}, BufferView{shards_[shard].url}, BufferView{content_type},
+                                                             BufferView{}, BufferView{body}, BufferView{}}, result, false);
+        if (answered && result.status_code == 200) {
+            ++sent_;
+            return true;
+        }
+        if (answered && result.status_code == 429) { penalize(shard, Session::retryAfter(result.headers)); }
+
+        bool retryable = !answered || result.status_code == 429 || result.status_code >= 500;
+        if (!retryable || attempt >= options_.max_retries) {
+            ++failed_;
+            std::cerr << "[slacking] webhook message given up. Reason: "
+                      << (answered ? std::to_string(result.status_code) + ' ' + result.body : result.error) << '\n';
+            return false;
+        }
+        ++retried_;
+    }
+}
+
+// Reserve the next slot of the url available first, then wait for it
+inline
+std::size_t WebhookClient::acquire() {
+    Clock::time_point allowed_at;
+    std::size_t chosen = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        auto burst = interval_ * (std::max(1u, options_.burst) - 1);
+        for (std::size_t i = 1; i < shards_.size(); ++i) {
+            if (shards_[i].tat < shards_[chosen].tat) { chosen = i; }
+        }
+        auto& shard = shards_[chosen];
+        allowed_at = shard.tat - burst;
+        shard.tat = std::max(shard.tat, now) + interval_;
+    }
+    if (allowed_at > Clock::now()) { std::this_thread::sleep_until(allowed_at); }
+    return chosen;
+}
+
+inline
+void WebhookClient::penalize(std::size_t shard, long retry_after) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& tat = shards_[shard].tat;
+    tat = std::max(tat, Clock::now() + std::chrono::seconds{std::max(1l, retry_after)});
+}
+
+inline
+void WebhookClient::drain() {
+    std::string body;
+    while (queue_.pop(body)) {
+        try { post_raw(body); }
+        catch (std::exception& e) {
+            ++failed_;
+            std::cerr << "[slacking] webhook message given up. Reason: " << e.what() << '\n';
+        }
+        done();
+    }
+}
+
+} // namespace _detail
+
+using _detail::WebhookOptions;
+using _detail::WebhookStats;
+using _detail::WebhookClient;
+
+} // namespace slack
+
+#endif // SLACKING_WEBHOOK_HPP_